@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../src/constants.h"
+#include "../src/evolution.h"
+#include "../src/expressions.h"
+#include "../src/fitness.h"
+#include "../src/tournament.h"
+
+constexpr std::uint64_t benchmarkSeed{0x5EED};
+
+constexpr int trialCount{15};
+
+/* The number of trees built, cloned, recombined, or mutated in a single trial. */
+constexpr int treesPerTrial{1000};
+
+struct Result
+{
+    std::string name;
+    int trials;
+    double medianNanoseconds;
+    double p95Nanoseconds;
+};
+
+std::vector<std::string> pinNames(int addressPins) {
+    std::vector<std::string> options{};
+    for (int i = 0; i < addressPins; i++) {
+        options.emplace_back(std::string{"a"} + std::to_string(i));
+    }
+    for (std::size_t i = 0; i < calculateCombinations(addressPins); i++) {
+        options.emplace_back(std::string{"d"} + std::to_string(i));
+    }
+    return options;
+}
+
+std::vector<std::unique_ptr<Expr>> randomTrees(const std::vector<std::string>& options,
+                                               int count) {
+    std::vector<std::unique_ptr<Expr>> trees{};
+    for (int i = 0; i < count; i++) {
+        trees.emplace_back(randomNode(options, initialDepth));
+    }
+    return trees;
+}
+
+/*
+ * Every trial first runs the setup, which is not timed, and then the body. Each trial seeds the
+ * generator with the same seed, so every trial does exactly the same work.
+ */
+Result measure(const std::string& name, int trials, const std::function<void()>& setup,
+               const std::function<void()>& body) {
+    std::vector<double> times{};
+    for (int i = 0; i < trials; i++) {
+        seedGenerator(benchmarkSeed);
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        body();
+        auto end = std::chrono::steady_clock::now();
+        times.emplace_back(std::chrono::duration<double, std::nano>(end - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    std::size_t p95 = (times.size() * 95 + 99) / 100 - 1;
+    return Result{name, trials, times[times.size() / 2], times[p95]};
+}
+
+int main() {
+    std::vector<Result> results{};
+    std::vector<std::string> options = pinNames(3);
+    std::vector<std::unique_ptr<Expr>> trees{};
+    std::vector<std::unique_ptr<Expr>> produced{};
+    auto makeTrees = [&] {
+        trees = randomTrees(options, treesPerTrial);
+        produced.clear();
+        produced.reserve(2 * treesPerTrial);
+    };
+    results.emplace_back(measure("random_node", trialCount, [&] { produced.clear(); }, [&] {
+        for (int i = 0; i < treesPerTrial; i++) {
+            produced.emplace_back(randomNode(options, initialDepth));
+        }
+    }));
+    results.emplace_back(measure("clone", trialCount, makeTrees, [&] {
+        for (const auto& tree : trees) {
+            produced.emplace_back(tree->clone());
+        }
+    }));
+    results.emplace_back(measure("recombination", trialCount, makeTrees, [&] {
+        for (int i = 0; i + 1 < treesPerTrial; i += 2) {
+            auto[first, second] = performRecombination(trees[i].get(), trees[i + 1].get());
+            produced.emplace_back(std::move(first));
+            produced.emplace_back(std::move(second));
+        }
+    }));
+    results.emplace_back(measure("mutation", trialCount, makeTrees, [&] {
+        for (const auto& tree : trees) {
+            produced.emplace_back(performMutation(tree.get(), options));
+        }
+    }));
+    for (int addressPins : {2, 3, 4}) {
+        std::vector<std::string> pins = pinNames(addressPins);
+        int count = addressPins < 4 ? 100 : 10;
+        TruthTable table{static_cast<std::size_t>(addressPins), pins.size()};
+        std::vector<std::unique_ptr<Expr>> scored{};
+        auto makeScored = [&] { scored = randomTrees(pins, count); };
+        std::string name = "fitness_" + std::to_string(addressPins) + "_address_pins";
+        results.emplace_back(measure(name, trialCount, makeScored, [&] {
+            for (const auto& tree : scored) {
+                static_cast<void>(computeFitness(tree.get(), table, Evaluator::bitSliced, -1));
+            }
+        }));
+    }
+    TruthTable table{3, options.size()};
+    Scoring scoring{3, options.size(), &table, Evaluator::bitSliced, nullptr, nullptr, nullptr,
+                    nullptr, true, false, nullptr};
+    std::vector<Individual<TreeLayout::Tree>> population{};
+    std::vector<Individual<TreeLayout::Tree>> updatedPopulation{};
+    auto makePopulation = [&](int size) {
+        population.clear();
+        for (int i = 0; i < size; i++) {
+            population.emplace_back(Individual<TreeLayout::Tree>{
+                    TreeLayout::random(options, initialDepth)});
+        }
+        updatedPopulation.clear();
+        updatedPopulation.resize(populationSize);
+    };
+    results.emplace_back(measure("tournament_selection", trialCount,
+                                 [&] { makePopulation(selectionPerTournament); }, [&] {
+        int remaining = selectionPerTournament;
+        static_cast<void>(tournamentSelection<TreeLayout>(scoring, population, remaining));
+    }));
+    results.emplace_back(measure("generation", 5, [&] { makePopulation(populationSize); }, [&] {
+        static_cast<void>(sequentialGeneration<TreeLayout>(scoring, options, population,
+                                                           updatedPopulation));
+    }));
+    std::cout << "{\n  \"seed\": " << benchmarkSeed << ",\n  \"benchmarks\": [\n";
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const Result& result = results[i];
+        std::cout << "    {\"name\": \"" << result.name << "\", \"trials\": " << result.trials
+                  << ", \"median_ns\": "
+                  << static_cast<std::uint64_t>(result.medianNanoseconds) << ", \"p95_ns\": "
+                  << static_cast<std::uint64_t>(result.p95Nanoseconds) << "}"
+                  << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    std::cout << "  ]\n}" << std::endl;
+    return 0;
+}
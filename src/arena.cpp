@@ -0,0 +1,137 @@
+#include <cassert>
+#include <cstdint>
+#include <new>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+#include "arena.h"
+
+constexpr std::size_t chunkSize{1 << 20};
+constexpr std::size_t hugePageSize{2 << 20};
+
+Arena::Arena(bool hugePages) : hugePages{hugePages} {}
+
+Arena::~Arena() {
+    for (Chunk& chunk : chunks) {
+#if defined(__linux__)
+        if (chunk.mapped) {
+            munmap(chunk.memory, chunk.size);
+            continue;
+        }
+#endif
+        ::operator delete(chunk.memory);
+    }
+}
+
+/*
+ * Huge page chunks first try explicit huge pages, and otherwise fall back to asking for
+ * transparent huge pages on a huge page aligned mapping.
+ */
+void Arena::addChunk(std::size_t minimumSize) {
+#if defined(__linux__)
+    if (hugePages) {
+        std::size_t size = (minimumSize + hugePageSize - 1) / hugePageSize * hugePageSize;
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1, 0);
+        if (memory == MAP_FAILED) {
+            memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+            if (memory == MAP_FAILED) {
+                throw std::bad_alloc{};
+            }
+            madvise(memory, size, MADV_HUGEPAGE);
+        }
+        chunks.push_back(Chunk{static_cast<char*>(memory), size, true});
+        return;
+    }
+#endif
+    std::size_t size = minimumSize < chunkSize ? chunkSize : minimumSize;
+    chunks.push_back(Chunk{static_cast<char*>(::operator new(size)), size, false});
+}
+
+void* Arena::allocate(std::size_t size, std::size_t alignment) {
+    while (true) {
+        if (chunkIndex == chunks.size()) {
+            addChunk(size + alignment);
+        }
+        Chunk& chunk = chunks[chunkIndex];
+        std::size_t aligned = (offset + alignment - 1) / alignment * alignment;
+        if (aligned + size <= chunk.size) {
+            offset = aligned + size;
+            return chunk.memory + aligned;
+        }
+        chunkIndex++;
+        offset = 0;
+    }
+}
+
+void Arena::reset() {
+    chunkIndex = 0;
+    offset = 0;
+}
+
+GenerationArenas::GenerationArenas(bool hugePages) : arenas{Arena{hugePages}, Arena{hugePages}} {}
+
+Arena& GenerationArenas::nextGeneration() {
+    return arenas[next];
+}
+
+void GenerationArenas::swap() {
+    next = 1 - next;
+    arenas[next].reset();
+}
+
+/*
+ * Every node is preceded by a header recording whether it came from an arena. Nodes only hold
+ * pointers and integers, so the header keeps them aligned.
+ */
+constexpr std::size_t nodeHeaderSize{sizeof(std::uint64_t)};
+constexpr std::uint64_t heapNode{0};
+constexpr std::uint64_t arenaNode{1};
+
+thread_local Arena* nodeArena = nullptr;
+
+thread_local NodeCounts nodeCounts{0, 0};
+
+void countNodeAllocation() {
+    nodeCounts.allocations++;
+}
+
+void countNodeRelease() {
+    nodeCounts.releases++;
+}
+
+NodeCounts takeNodeCounts() {
+    NodeCounts counts = nodeCounts;
+    nodeCounts = NodeCounts{0, 0};
+    return counts;
+}
+
+void setNodeArena(Arena* arena) {
+    nodeArena = arena;
+}
+
+void* allocateNode(std::size_t size) {
+    void* memory;
+    std::uint64_t origin;
+    if (nodeArena == nullptr) {
+        memory = ::operator new(size + nodeHeaderSize);
+        origin = heapNode;
+    } else {
+        memory = nodeArena->allocate(size + nodeHeaderSize, nodeHeaderSize);
+        origin = arenaNode;
+    }
+    *static_cast<std::uint64_t*>(memory) = origin;
+    countNodeAllocation();
+    return static_cast<char*>(memory) + nodeHeaderSize;
+}
+
+void releaseNode(void* pointer) {
+    if (pointer == nullptr) {
+        return;
+    }
+    countNodeRelease();
+    void* memory = static_cast<char*>(pointer) - nodeHeaderSize;
+    if (*static_cast<std::uint64_t*>(memory) == heapNode) {
+        ::operator delete(memory);
+    }
+}
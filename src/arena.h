@@ -0,0 +1,87 @@
+#ifndef GENETIC_MULTIPLEXER_ARENA_H
+#define GENETIC_MULTIPLEXER_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class NodeAllocator
+{
+    heap,
+    arena,
+    hugePages,
+};
+
+/*
+ * A bump allocator over a list of chunks. Individual allocations are never freed; instead the
+ * whole arena is reset at once, which keeps the chunks around for reuse.
+ */
+class Arena
+{
+private:
+    struct Chunk
+    {
+        char* memory;
+        std::size_t size;
+        bool mapped;
+    };
+    std::vector<Chunk> chunks{};
+    std::size_t chunkIndex{0};
+    std::size_t offset{0};
+    bool hugePages;
+    void addChunk(std::size_t minimumSize);
+public:
+    explicit Arena(bool hugePages);
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    ~Arena();
+    [[nodiscard]] void* allocate(std::size_t size, std::size_t alignment);
+    void reset();
+};
+
+/*
+ * Two arenas which alternate between holding the current and the next generation. Once the
+ * next generation is complete, nothing refers to the current arena anymore, so it is reset
+ * in constant time and becomes the arena of the generation after.
+ */
+class GenerationArenas
+{
+private:
+    Arena arenas[2];
+    int next{0};
+public:
+    explicit GenerationArenas(bool hugePages);
+    [[nodiscard]] Arena& nextGeneration();
+    void swap();
+};
+
+/*
+ * Routes expression node allocations made by the calling thread to the arena, or to the heap if
+ * the arena is null. Nodes remember where they came from, so deleting an arena node is a no-op
+ * and deleting a heap node frees it, regardless of the routing at deletion time.
+ */
+void setNodeArena(Arena* arena);
+
+void* allocateNode(std::size_t size);
+
+void releaseNode(void* pointer);
+
+struct NodeCounts
+{
+    std::uint64_t allocations;
+    std::uint64_t releases;
+};
+
+/*
+ * Tallies the nodes allocated and released by the calling thread. Expression nodes are tallied
+ * by allocateNode and releaseNode, whichever memory they come from, and shared nodes tally
+ * themselves.
+ */
+void countNodeAllocation();
+
+void countNodeRelease();
+
+/* Returns the nodes tallied by the calling thread since the last call, and starts over. */
+NodeCounts takeNodeCounts();
+
+#endif
@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <memory>
+#include "bdd.h"
+#include "constants.h"
+
+/* The pin of the terminal nodes comes after every real pin, so they sort last. */
+constexpr std::uint32_t terminalPin{UINT32_MAX};
+
+constexpr BddManager::Node emptySlot{UINT32_MAX};
+
+std::uint64_t mixBdd(std::uint64_t a, std::uint64_t b, std::uint64_t c) {
+    std::uint64_t z = a * 0x9E3779B97F4A7C15ULL ^ b * 0xBF58476D1CE4E5B9ULL ^ c;
+    z = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27U)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31U);
+}
+
+BddManager::BddManager(std::size_t addressPins, std::size_t optionsCount)
+        : addressPins{addressPins}, optionsCount{optionsCount} {
+    assert(optionsCount < 8 * sizeof(Count));
+    computed.resize(bddComputedEntries, Computed{emptySlot, 0, 0, 0});
+    clear();
+}
+
+void BddManager::clear() {
+    vertices.clear();
+    vertices.push_back(Vertex{terminalPin, falseNode, falseNode});
+    vertices.push_back(Vertex{terminalPin, trueNode, trueNode});
+    unique.assign(1024, emptySlot);
+    std::fill(computed.begin(), computed.end(), Computed{emptySlot, 0, 0, 0});
+    pinNodes.clear();
+    for (std::size_t i = 0; i < optionsCount; i++) {
+        pinNodes.push_back(makeNode(static_cast<std::uint32_t>(i), falseNode, trueNode));
+    }
+    target = buildMultiplexer(0, 0);
+}
+
+std::size_t BddManager::nodeCount() const {
+    return vertices.size();
+}
+
+std::size_t BddManager::uniqueSlot(std::uint32_t pin, Node low, Node high) const {
+    return mixBdd(pin, low, high) & (unique.size() - 1);
+}
+
+void BddManager::growUnique() {
+    unique.assign(2 * unique.size(), emptySlot);
+    for (Node node = trueNode + 1; node < vertices.size(); node++) {
+        const Vertex& vertex = vertices[node];
+        std::size_t slot = uniqueSlot(vertex.pin, vertex.low, vertex.high);
+        while (unique[slot] != emptySlot) {
+            slot = (slot + 1) & (unique.size() - 1);
+        }
+        unique[slot] = node;
+    }
+}
+
+/* Looks the node up by linear probing, creating it unless both branches are the same. */
+BddManager::Node BddManager::makeNode(std::uint32_t pin, Node low, Node high) {
+    if (low == high) {
+        return low;
+    }
+    std::size_t slot = uniqueSlot(pin, low, high);
+    while (unique[slot] != emptySlot) {
+        const Vertex& vertex = vertices[unique[slot]];
+        if (vertex.pin == pin && vertex.low == low && vertex.high == high) {
+            return unique[slot];
+        }
+        slot = (slot + 1) & (unique.size() - 1);
+    }
+    auto node = static_cast<Node>(vertices.size());
+    vertices.push_back(Vertex{pin, low, high});
+    unique[slot] = node;
+    if (2 * vertices.size() > unique.size()) {
+        growUnique();
+    }
+    return node;
+}
+
+BddManager::Node BddManager::cofactor(Node node, std::uint32_t pin, bool value) const {
+    const Vertex& vertex = vertices[node];
+    if (vertex.pin != pin) {
+        return node;
+    }
+    return value ? vertex.high : vertex.low;
+}
+
+/* Address pin zero is the most significant bit of the address, just like in the truth table. */
+BddManager::Node BddManager::buildMultiplexer(std::size_t pin, std::size_t address) {
+    if (pin == addressPins) {
+        return pinNodes[addressPins + address];
+    }
+    Node low = buildMultiplexer(pin + 1, 2 * address);
+    Node high = buildMultiplexer(pin + 1, 2 * address + 1);
+    return ifThenElse(pinNodes[pin], high, low);
+}
+
+BddManager::Node BddManager::ifThenElse(Node condition, Node trueCase, Node falseCase) {
+    if (condition == trueNode) {
+        return trueCase;
+    }
+    if (condition == falseNode) {
+        return falseCase;
+    }
+    if (trueCase == falseCase) {
+        return trueCase;
+    }
+    if (trueCase == trueNode && falseCase == falseNode) {
+        return condition;
+    }
+    std::size_t slot = mixBdd(condition, trueCase, falseCase) & (computed.size() - 1);
+    const Computed& entry = computed[slot];
+    if (entry.condition == condition && entry.trueCase == trueCase
+        && entry.falseCase == falseCase) {
+        return entry.result;
+    }
+    std::uint32_t top = std::min({vertices[condition].pin, vertices[trueCase].pin,
+                                  vertices[falseCase].pin});
+    Node high = ifThenElse(cofactor(condition, top, true), cofactor(trueCase, top, true),
+                           cofactor(falseCase, top, true));
+    Node low = ifThenElse(cofactor(condition, top, false), cofactor(trueCase, top, false),
+                          cofactor(falseCase, top, false));
+    Node result = makeNode(top, low, high);
+    computed[slot] = Computed{condition, trueCase, falseCase, result};
+    return result;
+}
+
+/* Walks the genes backwards so that the operands of every node are already on the stack. */
+BddManager::Node BddManager::compile(const std::vector<Gene>& genes) {
+    std::vector<Node> stack{};
+    for (auto gene = genes.rbegin(); gene != genes.rend(); ++gene) {
+        switch (gene->op) {
+            case Opcode::Terminal:
+                stack.push_back(pinNodes[gene->terminal]);
+                break;
+            case Opcode::Not:
+                stack.back() = ifThenElse(stack.back(), falseNode, trueNode);
+                break;
+            case Opcode::And: {
+                Node first = stack.back();
+                stack.pop_back();
+                stack.back() = ifThenElse(first, stack.back(), falseNode);
+                break;
+            }
+            case Opcode::Or: {
+                Node first = stack.back();
+                stack.pop_back();
+                stack.back() = ifThenElse(first, trueNode, stack.back());
+                break;
+            }
+            case Opcode::If: {
+                Node condition = stack.back();
+                stack.pop_back();
+                Node trueCase = stack.back();
+                stack.pop_back();
+                stack.back() = ifThenElse(condition, trueCase, stack.back());
+                break;
+            }
+        }
+    }
+    assert(stack.size() == 1);
+    return stack.back();
+}
+
+/* The terminals sit below every pin, so that the pins skipped on the way to them are counted. */
+std::uint32_t BddManager::level(Node node) const {
+    return node <= trueNode ? static_cast<std::uint32_t>(optionsCount) : vertices[node].pin;
+}
+
+/*
+ * The number of assignments of the pins from that of the node onwards under which it is true.
+ * Each branch counts its own pins onwards, so it is scaled by the pins which it skips, since
+ * the function is the same whatever their values.
+ */
+BddManager::Count BddManager::modelCount(Node node) {
+    if (node <= trueNode) {
+        return node;
+    }
+    if (countStamps[node] == stamp) {
+        return counts[node];
+    }
+    const Vertex& vertex = vertices[node];
+    Count low = modelCount(vertex.low) << (level(vertex.low) - vertex.pin - 1);
+    Count high = modelCount(vertex.high) << (level(vertex.high) - vertex.pin - 1);
+    counts[node] = low + high;
+    countStamps[node] = stamp;
+    return low + high;
+}
+
+BddManager::Count BddManager::agreeingRows(Node function) {
+    Node agreeing = ifThenElse(function, target, ifThenElse(target, falseNode, trueNode));
+    counts.resize(vertices.size());
+    countStamps.resize(vertices.size(), 0);
+    if (++stamp == 0) {
+        std::fill(countStamps.begin(), countStamps.end(), 0);
+        stamp = 1;
+    }
+    return modelCount(agreeing) << level(agreeing);
+}
+
+double bddAgreement(const std::vector<Gene>& genes, std::size_t addressPins,
+                    std::size_t optionsCount) {
+    thread_local std::unique_ptr<BddManager> manager{};
+    thread_local std::size_t managedPins{0};
+    if (!manager || managedPins != addressPins) {
+        manager = std::make_unique<BddManager>(addressPins, optionsCount);
+        managedPins = addressPins;
+    } else if (manager->nodeCount() > bddNodeLimit) {
+        manager->clear();
+    }
+    BddManager::Count rows = BddManager::Count{1} << optionsCount;
+    BddManager::Count agreeing = manager->agreeingRows(manager->compile(genes));
+    if (agreeing == rows) {
+        return 1;
+    }
+    return std::min(static_cast<double>(agreeing) / static_cast<double>(rows),
+                    std::nextafter(1.0, 0.0));
+}
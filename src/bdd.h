@@ -0,0 +1,74 @@
+#ifndef GENETIC_MULTIPLEXER_BDD_H
+#define GENETIC_MULTIPLEXER_BDD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "genome.h"
+
+/*
+ * Reduced ordered binary decision diagrams over the pins of a multiplexer, with the address
+ * pins ordered before the data pins so that the multiplexer itself only needs one node per pin.
+ * The unique table guarantees that equal functions are the same node, and the computed cache
+ * remembers the results of if-then-else across trees until the manager is cleared.
+ */
+class BddManager
+{
+public:
+    using Node = std::uint32_t;
+    /* Counts every assignment of up to 127 pins, which covers the seventy options of six pins. */
+    using Count = unsigned __int128;
+    static constexpr Node falseNode{0};
+    static constexpr Node trueNode{1};
+private:
+    struct Vertex
+    {
+        std::uint32_t pin;
+        Node low;
+        Node high;
+    };
+    struct Computed
+    {
+        Node condition;
+        Node trueCase;
+        Node falseCase;
+        Node result;
+    };
+    std::size_t addressPins;
+    std::size_t optionsCount;
+    std::vector<Vertex> vertices{};
+    std::vector<Node> unique{};
+    std::vector<Computed> computed{};
+    std::vector<Node> pinNodes{};
+    Node target{falseNode};
+    std::vector<Count> counts{};
+    std::vector<std::uint32_t> countStamps{};
+    std::uint32_t stamp{0};
+    [[nodiscard]] std::size_t uniqueSlot(std::uint32_t pin, Node low, Node high) const;
+    void growUnique();
+    [[nodiscard]] Node makeNode(std::uint32_t pin, Node low, Node high);
+    [[nodiscard]] Node cofactor(Node node, std::uint32_t pin, bool value) const;
+    [[nodiscard]] Node buildMultiplexer(std::size_t pin, std::size_t address);
+    [[nodiscard]] std::uint32_t level(Node node) const;
+    [[nodiscard]] Count modelCount(Node node);
+public:
+    BddManager(std::size_t addressPins, std::size_t optionsCount);
+    /* Drops every node except the pins and the multiplexer, once too many have piled up. */
+    void clear();
+    [[nodiscard]] std::size_t nodeCount() const;
+    [[nodiscard]] Node ifThenElse(Node condition, Node trueCase, Node falseCase);
+    /* Builds the function of the tree whose genes are in prefix order. */
+    [[nodiscard]] Node compile(const std::vector<Gene>& genes);
+    /* The number of pin assignments where the function agrees with the multiplexer. */
+    [[nodiscard]] Count agreeingRows(Node function);
+};
+
+/*
+ * Exactly counts the truth table rows where the tree agrees with the multiplexer, on a manager
+ * owned by the calling thread, and returns them as a fraction of all rows. Returns exactly one
+ * only for a perfect tree, so an imperfect one is rounded down to just below one.
+ */
+double bddAgreement(const std::vector<Gene>& genes, std::size_t addressPins,
+                    std::size_t optionsCount);
+
+#endif
@@ -0,0 +1,436 @@
+#include <algorithm>
+#include <cassert>
+#include <string>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+#include "constants.h"
+#include "bitslice.h"
+
+/* The column of a pin whose row bit offset is below six repeats within every word. */
+constexpr std::uint64_t inWordPatterns[]{
+        0xAAAAAAAAAAAAAAAAULL,
+        0xCCCCCCCCCCCCCCCCULL,
+        0xF0F0F0F0F0F0F0F0ULL,
+        0xFF00FF00FF00FF00ULL,
+        0xFFFF0000FFFF0000ULL,
+        0xFFFFFFFF00000000ULL,
+};
+
+TruthTable::TruthTable(std::size_t addressPins, std::size_t optionsCount)
+        : addressPins{addressPins}, optionsCount{optionsCount} {
+    totalWords = columnWords(optionsCount);
+    if (totalWords == 0) {
+        return;
+    }
+    std::size_t combinations = static_cast<std::size_t>(1) << optionsCount;
+    std::size_t finalRows = combinations % rowsPerWord;
+    finalMask = finalRows == 0 ? ~0ULL : (1ULL << finalRows) - 1;
+    if (!precomputes(optionsCount)) {
+        return;
+    }
+    columns.resize(optionsCount * totalWords);
+    target.resize(totalWords);
+    for (std::size_t i = 0; i < blockCount(); i++) {
+        std::size_t firstWord = i * bitSlicedBlockWords;
+        generate(i, columns.data() + optionsCount * firstWord, target.data() + firstWord);
+    }
+}
+
+std::size_t TruthTable::columnWords(std::size_t optionsCount) {
+    if (optionsCount >= 64) {
+        return 0;
+    }
+    std::size_t combinations = static_cast<std::size_t>(1) << optionsCount;
+    return (combinations + rowsPerWord - 1) / rowsPerWord;
+}
+
+bool TruthTable::precomputes(std::size_t optionsCount) {
+    std::size_t words = columnWords(optionsCount);
+    return words > 0 && words <= precomputedTableWords / (optionsCount + 1);
+}
+
+std::size_t TruthTable::addressPinCount() const {
+    return addressPins;
+}
+
+std::size_t TruthTable::optionCount() const {
+    return optionsCount;
+}
+
+bool TruthTable::isPrecomputed() const {
+    return !target.empty();
+}
+
+std::size_t TruthTable::blockCount() const {
+    return (totalWords + bitSlicedBlockWords - 1) / bitSlicedBlockWords;
+}
+
+RowBlock TruthTable::generate(std::size_t blockIndex, std::uint64_t* blockColumns,
+                              std::uint64_t* blockTarget) const {
+    assert(blockIndex < blockCount());
+    std::size_t firstWord = blockIndex * bitSlicedBlockWords;
+    std::size_t words = std::min(bitSlicedBlockWords, totalWords - firstWord);
+    for (std::size_t pin = 0; pin < optionsCount; pin++) {
+        std::uint64_t* column = blockColumns + pin * words;
+        std::size_t offset = (optionsCount - 1) - pin;
+        for (std::size_t w = 0; w < words; w++) {
+            if (offset < 6) {
+                column[w] = inWordPatterns[offset];
+            } else {
+                bool set = ((firstWord + w) >> (offset - 6)) & 1U;
+                column[w] = set ? ~0ULL : 0;
+            }
+        }
+    }
+    std::size_t dataPins = optionsCount - addressPins;
+    std::fill(blockTarget, blockTarget + words, 0);
+    for (std::size_t address = 0; address < dataPins; address++) {
+        const std::uint64_t* data = blockColumns + (addressPins + address) * words;
+        for (std::size_t w = 0; w < words; w++) {
+            std::uint64_t match = ~0ULL;
+            for (std::size_t j = 0; j < addressPins; j++) {
+                std::uint64_t pin = blockColumns[j * words + w];
+                bool set = (address >> ((addressPins - 1) - j)) & 1U;
+                match &= set ? pin : ~pin;
+            }
+            blockTarget[w] |= match & data[w];
+        }
+    }
+    bool isFinal = firstWord + words == totalWords;
+    return RowBlock{words, isFinal ? finalMask : ~0ULL, blockColumns, blockTarget, words};
+}
+
+RowBlock TruthTable::block(std::size_t blockIndex) const {
+    assert(isPrecomputed() && blockIndex < blockCount());
+    std::size_t firstWord = blockIndex * bitSlicedBlockWords;
+    std::size_t words = std::min(bitSlicedBlockWords, totalWords - firstWord);
+    bool isFinal = firstWord + words == totalWords;
+    return RowBlock{words, isFinal ? finalMask : ~0ULL, columns.data() + optionsCount * firstWord,
+                    target.data() + firstWord, words};
+}
+
+bool TruthTable::expected(std::size_t row) const {
+    if (isPrecomputed()) {
+        return (target[row / rowsPerWord] >> (row % rowsPerWord)) & 1U;
+    }
+    std::size_t address = row >> (optionsCount - addressPins);
+    std::size_t dataPin = addressPins + address;
+    return (row >> ((optionsCount - 1) - dataPin)) & 1U;
+}
+
+RowBlockGenerator::RowBlockGenerator(const TruthTable& table) : table{table} {
+    if (!table.isPrecomputed()) {
+        columns.resize(table.optionCount() * bitSlicedBlockWords);
+        target.resize(bitSlicedBlockWords);
+    }
+}
+
+std::size_t RowBlockGenerator::blockCount() const {
+    return table.blockCount();
+}
+
+RowBlock RowBlockGenerator::generate(std::size_t blockIndex) {
+    if (table.isPrecomputed()) {
+        return table.block(blockIndex);
+    }
+    return table.generate(blockIndex, columns.data(), target.data());
+}
+
+/*
+ * The count kernels return the number of set bits in the complement of predicted xor target,
+ * over whole words only; the caller masks the final word of the truth table.
+ */
+struct BitKernels
+{
+    const char* name;
+    void (*bitNot)(std::uint64_t*, std::size_t);
+    void (*bitAnd)(std::uint64_t*, const std::uint64_t*, std::size_t);
+    void (*bitOr)(std::uint64_t*, const std::uint64_t*, std::size_t);
+    void (*bitSelect)(std::uint64_t*, const std::uint64_t*, const std::uint64_t*, std::size_t);
+    std::uint64_t (*countAgreement)(const std::uint64_t*, const std::uint64_t*, std::size_t);
+};
+
+void scalarNot(std::uint64_t* out, std::size_t words) {
+    for (std::size_t i = 0; i < words; i++) {
+        out[i] = ~out[i];
+    }
+}
+
+void scalarAnd(std::uint64_t* out, const std::uint64_t* other, std::size_t words) {
+    for (std::size_t i = 0; i < words; i++) {
+        out[i] &= other[i];
+    }
+}
+
+void scalarOr(std::uint64_t* out, const std::uint64_t* other, std::size_t words) {
+    for (std::size_t i = 0; i < words; i++) {
+        out[i] |= other[i];
+    }
+}
+
+void scalarSelect(std::uint64_t* out, const std::uint64_t* trueCase,
+                  const std::uint64_t* falseCase, std::size_t words) {
+    for (std::size_t i = 0; i < words; i++) {
+        out[i] = (out[i] & trueCase[i]) | (~out[i] & falseCase[i]);
+    }
+}
+
+std::uint64_t scalarCountAgreement(const std::uint64_t* predicted, const std::uint64_t* target,
+                                   std::size_t words) {
+    std::uint64_t agree = 0;
+    for (std::size_t i = 0; i < words; i++) {
+        agree += __builtin_popcountll(~(predicted[i] ^ target[i]));
+    }
+    return agree;
+}
+
+constexpr BitKernels scalarKernels{"scalar", scalarNot, scalarAnd, scalarOr, scalarSelect,
+                                   scalarCountAgreement};
+
+#if defined(__x86_64__)
+
+__attribute__((target("avx2"))) void avx2Not(std::uint64_t* out, std::size_t words) {
+    std::size_t i = 0;
+    __m256i ones = _mm256_set1_epi64x(-1);
+    for (; i + 4 <= words; i += 4) {
+        auto* lane = reinterpret_cast<__m256i*>(out + i);
+        _mm256_storeu_si256(lane, _mm256_xor_si256(_mm256_loadu_si256(lane), ones));
+    }
+    scalarNot(out + i, words - i);
+}
+
+__attribute__((target("avx2")))
+void avx2And(std::uint64_t* out, const std::uint64_t* other, std::size_t words) {
+    std::size_t i = 0;
+    for (; i + 4 <= words; i += 4) {
+        auto* lane = reinterpret_cast<__m256i*>(out + i);
+        auto* otherLane = reinterpret_cast<const __m256i*>(other + i);
+        __m256i value = _mm256_and_si256(_mm256_loadu_si256(lane), _mm256_loadu_si256(otherLane));
+        _mm256_storeu_si256(lane, value);
+    }
+    scalarAnd(out + i, other + i, words - i);
+}
+
+__attribute__((target("avx2")))
+void avx2Or(std::uint64_t* out, const std::uint64_t* other, std::size_t words) {
+    std::size_t i = 0;
+    for (; i + 4 <= words; i += 4) {
+        auto* lane = reinterpret_cast<__m256i*>(out + i);
+        auto* otherLane = reinterpret_cast<const __m256i*>(other + i);
+        __m256i value = _mm256_or_si256(_mm256_loadu_si256(lane), _mm256_loadu_si256(otherLane));
+        _mm256_storeu_si256(lane, value);
+    }
+    scalarOr(out + i, other + i, words - i);
+}
+
+__attribute__((target("avx2")))
+void avx2Select(std::uint64_t* out, const std::uint64_t* trueCase,
+                const std::uint64_t* falseCase, std::size_t words) {
+    std::size_t i = 0;
+    for (; i + 4 <= words; i += 4) {
+        auto* lane = reinterpret_cast<__m256i*>(out + i);
+        __m256i mask = _mm256_loadu_si256(lane);
+        __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(trueCase + i));
+        __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(falseCase + i));
+        __m256i value = _mm256_or_si256(_mm256_and_si256(mask, t), _mm256_andnot_si256(mask, f));
+        _mm256_storeu_si256(lane, value);
+    }
+    scalarSelect(out + i, trueCase + i, falseCase + i, words - i);
+}
+
+/* AVX2 has no vector population count, so the agreement is reduced with the popcnt instruction. */
+__attribute__((target("avx2,popcnt")))
+std::uint64_t avx2CountAgreement(const std::uint64_t* predicted, const std::uint64_t* target,
+                                 std::size_t words) {
+    std::uint64_t agree = 0;
+    std::size_t i = 0;
+    __m256i ones = _mm256_set1_epi64x(-1);
+    alignas(32) std::uint64_t lanes[4];
+    for (; i + 4 <= words; i += 4) {
+        __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(predicted + i));
+        __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(target + i));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes),
+                           _mm256_xor_si256(_mm256_xor_si256(p, t), ones));
+        agree += _mm_popcnt_u64(lanes[0]) + _mm_popcnt_u64(lanes[1])
+                 + _mm_popcnt_u64(lanes[2]) + _mm_popcnt_u64(lanes[3]);
+    }
+    return agree + scalarCountAgreement(predicted + i, target + i, words - i);
+}
+
+constexpr BitKernels avx2Kernels{"avx2", avx2Not, avx2And, avx2Or, avx2Select,
+                                 avx2CountAgreement};
+
+/* Ternary logic immediates, indexed by the bits of the first, second, and third operand. */
+constexpr int ternaryNot{0x55};
+constexpr int ternarySelect{0xCA};
+constexpr int ternaryEquivalent{0x99};
+
+__attribute__((target("avx512f"))) void avx512Not(std::uint64_t* out, std::size_t words) {
+    std::size_t i = 0;
+    for (; i + 8 <= words; i += 8) {
+        __m512i value = _mm512_loadu_si512(out + i);
+        _mm512_storeu_si512(out + i, _mm512_ternarylogic_epi64(value, value, value, ternaryNot));
+    }
+    scalarNot(out + i, words - i);
+}
+
+__attribute__((target("avx512f")))
+void avx512And(std::uint64_t* out, const std::uint64_t* other, std::size_t words) {
+    std::size_t i = 0;
+    for (; i + 8 <= words; i += 8) {
+        __m512i value = _mm512_loadu_si512(out + i);
+        _mm512_storeu_si512(out + i, _mm512_and_si512(value, _mm512_loadu_si512(other + i)));
+    }
+    scalarAnd(out + i, other + i, words - i);
+}
+
+__attribute__((target("avx512f")))
+void avx512Or(std::uint64_t* out, const std::uint64_t* other, std::size_t words) {
+    std::size_t i = 0;
+    for (; i + 8 <= words; i += 8) {
+        __m512i value = _mm512_loadu_si512(out + i);
+        _mm512_storeu_si512(out + i, _mm512_or_si512(value, _mm512_loadu_si512(other + i)));
+    }
+    scalarOr(out + i, other + i, words - i);
+}
+
+__attribute__((target("avx512f")))
+void avx512Select(std::uint64_t* out, const std::uint64_t* trueCase,
+                  const std::uint64_t* falseCase, std::size_t words) {
+    std::size_t i = 0;
+    for (; i + 8 <= words; i += 8) {
+        __m512i mask = _mm512_loadu_si512(out + i);
+        __m512i t = _mm512_loadu_si512(trueCase + i);
+        __m512i f = _mm512_loadu_si512(falseCase + i);
+        _mm512_storeu_si512(out + i, _mm512_ternarylogic_epi64(mask, t, f, ternarySelect));
+    }
+    scalarSelect(out + i, trueCase + i, falseCase + i, words - i);
+}
+
+/* Skylake-SP lacks the vector population count, so the lanes are reduced with popcnt. */
+__attribute__((target("avx512f,popcnt")))
+std::uint64_t avx512CountAgreement(const std::uint64_t* predicted, const std::uint64_t* target,
+                                   std::size_t words) {
+    std::uint64_t agree = 0;
+    std::size_t i = 0;
+    alignas(64) std::uint64_t lanes[8];
+    for (; i + 8 <= words; i += 8) {
+        __m512i p = _mm512_loadu_si512(predicted + i);
+        __m512i t = _mm512_loadu_si512(target + i);
+        _mm512_store_si512(lanes, _mm512_ternarylogic_epi64(p, t, p, ternaryEquivalent));
+        for (std::uint64_t lane : lanes) {
+            agree += _mm_popcnt_u64(lane);
+        }
+    }
+    return agree + scalarCountAgreement(predicted + i, target + i, words - i);
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq")))
+std::uint64_t avx512PopcntCountAgreement(const std::uint64_t* predicted,
+                                         const std::uint64_t* target, std::size_t words) {
+    std::size_t i = 0;
+    __m512i sum = _mm512_setzero_si512();
+    for (; i + 8 <= words; i += 8) {
+        __m512i p = _mm512_loadu_si512(predicted + i);
+        __m512i t = _mm512_loadu_si512(target + i);
+        __m512i agreement = _mm512_ternarylogic_epi64(p, t, p, ternaryEquivalent);
+        sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(agreement));
+    }
+    alignas(64) std::uint64_t lanes[8];
+    _mm512_store_si512(lanes, sum);
+    std::uint64_t agree = 0;
+    for (std::uint64_t lane : lanes) {
+        agree += lane;
+    }
+    return agree + scalarCountAgreement(predicted + i, target + i, words - i);
+}
+
+constexpr BitKernels avx512Kernels{"avx512", avx512Not, avx512And, avx512Or, avx512Select,
+                                   avx512CountAgreement};
+
+constexpr BitKernels avx512PopcntKernels{"avx512-vpopcntdq", avx512Not, avx512And, avx512Or,
+                                         avx512Select, avx512PopcntCountAgreement};
+
+#endif
+
+/* Picks the widest kernels that the running processor supports. */
+const BitKernels& detectKernels() {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        if (__builtin_cpu_supports("avx512vpopcntdq")) {
+            return avx512PopcntKernels;
+        }
+        return avx512Kernels;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return avx2Kernels;
+    }
+#endif
+    return scalarKernels;
+}
+
+const BitKernels* kernels = &detectKernels();
+
+const char* bitKernelName() {
+    return kernels->name;
+}
+
+bool selectBitKernels(const std::string& name) {
+    if (name == "auto") {
+        kernels = &detectKernels();
+        return true;
+    }
+    if (name == scalarKernels.name) {
+        kernels = &scalarKernels;
+        return true;
+    }
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (name == avx2Kernels.name && __builtin_cpu_supports("avx2")) {
+        kernels = &avx2Kernels;
+        return true;
+    }
+    if (name == avx512Kernels.name && __builtin_cpu_supports("avx512f")) {
+        kernels = &avx512Kernels;
+        return true;
+    }
+    if (name == avx512PopcntKernels.name && __builtin_cpu_supports("avx512f")
+        && __builtin_cpu_supports("avx512vpopcntdq")) {
+        kernels = &avx512PopcntKernels;
+        return true;
+    }
+#endif
+    return false;
+}
+
+void bitNot(std::uint64_t* out, std::size_t words) {
+    kernels->bitNot(out, words);
+}
+
+void bitAnd(std::uint64_t* out, const std::uint64_t* other, std::size_t words) {
+    kernels->bitAnd(out, other, words);
+}
+
+void bitOr(std::uint64_t* out, const std::uint64_t* other, std::size_t words) {
+    kernels->bitOr(out, other, words);
+}
+
+void bitSelect(std::uint64_t* out, const std::uint64_t* trueCase, const std::uint64_t* falseCase,
+               std::size_t words) {
+    kernels->bitSelect(out, trueCase, falseCase, words);
+}
+
+std::uint64_t countAgreement(const std::uint64_t* predicted, const RowBlock& block) {
+    assert(block.words > 0);
+    std::size_t last = block.words - 1;
+    std::uint64_t agree = kernels->countAgreement(predicted, block.target, last);
+    agree += __builtin_popcountll(~(predicted[last] ^ block.target[last]) & block.validMask);
+    return agree;
+}
+
+std::uint64_t countAgreement(const std::uint64_t* predicted, const std::uint64_t* target,
+                             std::size_t words) {
+    return kernels->countAgreement(predicted, target, words);
+}
@@ -0,0 +1,121 @@
+#ifndef GENETIC_MULTIPLEXER_BITSLICE_H
+#define GENETIC_MULTIPLEXER_BITSLICE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+constexpr std::size_t rowsPerWord{64};
+
+/*
+ * A contiguous run of truth table rows packed 64 rows per word. Each pin has a column of
+ * words, laid out pin-major the stride apart, and the target column holds the expected
+ * multiplexer output. Bits past the final row are garbage and must be masked out with the valid
+ * mask. The stride is the block words, unless the block is a slice of a wider one.
+ */
+struct RowBlock
+{
+    std::size_t words;
+    std::uint64_t validMask;
+    const std::uint64_t* columns;
+    const std::uint64_t* target;
+    std::size_t stride;
+
+    [[nodiscard]] const std::uint64_t* column(std::size_t pin) const {
+        return columns + pin * stride;
+    }
+
+    /* The rows of at most the count words from the first word on. */
+    [[nodiscard]] RowBlock slice(std::size_t first, std::size_t count) const {
+        std::size_t sliceWords = std::min(count, words - first);
+        bool isFinal = first + sliceWords == words;
+        return RowBlock{sliceWords, isFinal ? validMask : ~0ULL, columns + first, target + first,
+                        stride};
+    }
+};
+
+/*
+ * The pin columns and multiplexer output of every row of the truth table, built once per run and
+ * then shared read-only by every evaluation. Row i assigns pin j the bit at offset
+ * (optionsCount - 1 - j) of i. The blocks are stored one after the other, so the target forms a
+ * single bitmap over all rows. Truth tables too large to precompute keep no blocks at all, and
+ * those with more rows than a std::size_t can count have no blocks, since only the decision
+ * diagram evaluator scores them.
+ */
+class TruthTable
+{
+private:
+    std::size_t addressPins;
+    std::size_t optionsCount;
+    std::size_t totalWords{0};
+    std::uint64_t finalMask{~0ULL};
+    std::vector<std::uint64_t> columns{};
+    std::vector<std::uint64_t> target{};
+public:
+    TruthTable(std::size_t addressPins, std::size_t optionsCount);
+    /* The words of each column over all rows, which is zero if the rows cannot be counted. */
+    [[nodiscard]] static std::size_t columnWords(std::size_t optionsCount);
+    /* Whether the blocks of a truth table with the options are built once per run. */
+    [[nodiscard]] static bool precomputes(std::size_t optionsCount);
+    [[nodiscard]] std::size_t addressPinCount() const;
+    [[nodiscard]] std::size_t optionCount() const;
+    [[nodiscard]] bool isPrecomputed() const;
+    [[nodiscard]] std::size_t blockCount() const;
+    /* Fills the block into the given columns and target, which must have room for its words. */
+    RowBlock generate(std::size_t blockIndex, std::uint64_t* blockColumns,
+                      std::uint64_t* blockTarget) const;
+    /* The block must be precomputed. */
+    [[nodiscard]] RowBlock block(std::size_t blockIndex) const;
+    /* The multiplexer output of the row, which is looked up when precomputed. */
+    [[nodiscard]] bool expected(std::size_t row) const;
+};
+
+/*
+ * Hands out the row blocks of a truth table, pointing into it when it is precomputed, and
+ * otherwise generating each block into memory of its own.
+ */
+class RowBlockGenerator
+{
+private:
+    const TruthTable& table;
+    std::vector<std::uint64_t> columns{};
+    std::vector<std::uint64_t> target{};
+public:
+    explicit RowBlockGenerator(const TruthTable& table);
+    [[nodiscard]] std::size_t blockCount() const;
+    [[nodiscard]] RowBlock generate(std::size_t blockIndex);
+};
+
+/*
+ * The bitwise kernels below dispatch at startup to the widest vector instructions that the
+ * processor supports, falling back to portable scalar code.
+ */
+const char* bitKernelName();
+
+/*
+ * Overrides the detected kernels with the named ones (auto, scalar, avx2, avx512, or
+ * avx512-vpopcntdq), where avx512 counts agreement without the vpopcntdq extension. Returns
+ * false if the name is unknown or the processor does not support the instructions.
+ */
+bool selectBitKernels(const std::string& name);
+
+void bitNot(std::uint64_t* out, std::size_t words);
+
+void bitAnd(std::uint64_t* out, const std::uint64_t* other, std::size_t words);
+
+void bitOr(std::uint64_t* out, const std::uint64_t* other, std::size_t words);
+
+/* Each output bit becomes the true case bit where it was set, otherwise the false case bit. */
+void bitSelect(std::uint64_t* out, const std::uint64_t* trueCase, const std::uint64_t* falseCase,
+               std::size_t words);
+
+/* Counts the rows in the block where the predicted output matches the multiplexer output. */
+std::uint64_t countAgreement(const std::uint64_t* predicted, const RowBlock& block);
+
+/* Counts the bits which agree over whole words, where every bit is a valid row. */
+std::uint64_t countAgreement(const std::uint64_t* predicted, const std::uint64_t* target,
+                             std::size_t words);
+
+#endif
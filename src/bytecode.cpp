@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <cassert>
+#include "bytecode.h"
+
+BytecodeProgram::BytecodeProgram(const std::vector<Gene>& genes) {
+    compile(genes);
+}
+
+/* Every logic node has at most three children, so there are at most 3n + 1 genes in total. */
+BytecodeProgram::BytecodeProgram(const Expr& head) {
+    std::vector<Gene> genes{};
+    genes.reserve(3 * static_cast<std::size_t>(head.computeLogicSize()) + 1);
+    head.appendGenes(genes);
+    compile(genes);
+}
+
+void BytecodeProgram::compile(const std::vector<Gene>& genes) {
+    operations.reserve(genes.size());
+    std::size_t index = 0;
+    int stack = 0;
+    emit(genes, index, stack);
+    assert(index == genes.size() && stack == 1);
+}
+
+/* Emits the subtree starting at the index, which is then advanced past the subtree. */
+void BytecodeProgram::emit(const std::vector<Gene>& genes, std::size_t& index, int& stack) {
+    auto isTerminal = [&genes](std::size_t at) {
+        return genes[at].op == Opcode::Terminal;
+    };
+    auto push = [this, &stack]() {
+        stack++;
+        maximumStack = std::max(maximumStack, stack);
+    };
+    Gene gene = genes[index++];
+    switch (gene.op) {
+        case Opcode::Terminal:
+            operations.push_back(Operation{Instruction::PushPin, {gene.terminal, 0, 0}});
+            push();
+            return;
+        case Opcode::Not:
+            if (isTerminal(index)) {
+                std::uint16_t pin = genes[index++].terminal;
+                operations.push_back(Operation{Instruction::NotPin, {pin, 0, 0}});
+                push();
+                return;
+            }
+            emit(genes, index, stack);
+            operations.push_back(Operation{Instruction::Not, {0, 0, 0}});
+            return;
+        case Opcode::And:
+        case Opcode::Or: {
+            bool isAnd = gene.op == Opcode::And;
+            if (isTerminal(index)) {
+                std::uint16_t first = genes[index++].terminal;
+                if (isTerminal(index)) {
+                    std::uint16_t second = genes[index++].terminal;
+                    Instruction both = isAnd ? Instruction::AndPins : Instruction::OrPins;
+                    operations.push_back(Operation{both, {first, second, 0}});
+                    push();
+                    return;
+                }
+                emit(genes, index, stack);
+                Instruction one = isAnd ? Instruction::AndPin : Instruction::OrPin;
+                operations.push_back(Operation{one, {first, 0, 0}});
+                return;
+            }
+            emit(genes, index, stack);
+            if (isTerminal(index)) {
+                std::uint16_t second = genes[index++].terminal;
+                Instruction one = isAnd ? Instruction::AndPin : Instruction::OrPin;
+                operations.push_back(Operation{one, {second, 0, 0}});
+                return;
+            }
+            emit(genes, index, stack);
+            Instruction neither = isAnd ? Instruction::And : Instruction::Or;
+            operations.push_back(Operation{neither, {0, 0, 0}});
+            stack--;
+            return;
+        }
+        case Opcode::If:
+            if (isTerminal(index) && isTerminal(index + 1) && isTerminal(index + 2)) {
+                std::uint16_t condition = genes[index++].terminal;
+                std::uint16_t trueCase = genes[index++].terminal;
+                std::uint16_t falseCase = genes[index++].terminal;
+                operations.push_back(Operation{Instruction::IfPins,
+                                               {condition, trueCase, falseCase}});
+                push();
+                return;
+            }
+            for (int i = 0; i < 3; i++) {
+                emit(genes, index, stack);
+            }
+            operations.push_back(Operation{Instruction::If, {0, 0, 0}});
+            stack -= 2;
+            return;
+    }
+}
+
+std::size_t BytecodeProgram::size() const {
+    return operations.size();
+}
+
+int BytecodeProgram::stackDepth() const {
+    return maximumStack;
+}
+
+void BytecodeProgram::evaluate(const RowBlock& block, std::uint64_t* out,
+                               std::uint64_t* scratch) const {
+    std::size_t words = block.words;
+    std::uint64_t* top = scratch;
+    for (const Operation& operation : operations) {
+        const std::uint16_t* pins = operation.pins;
+        switch (operation.instruction) {
+            case Instruction::PushPin: {
+                const std::uint64_t* column = block.column(pins[0]);
+                std::copy(column, column + words, top);
+                top += words;
+                break;
+            }
+            case Instruction::NotPin: {
+                const std::uint64_t* column = block.column(pins[0]);
+                std::copy(column, column + words, top);
+                bitNot(top, words);
+                top += words;
+                break;
+            }
+            case Instruction::AndPins: {
+                const std::uint64_t* column = block.column(pins[0]);
+                std::copy(column, column + words, top);
+                bitAnd(top, block.column(pins[1]), words);
+                top += words;
+                break;
+            }
+            case Instruction::OrPins: {
+                const std::uint64_t* column = block.column(pins[0]);
+                std::copy(column, column + words, top);
+                bitOr(top, block.column(pins[1]), words);
+                top += words;
+                break;
+            }
+            case Instruction::IfPins: {
+                const std::uint64_t* column = block.column(pins[0]);
+                std::copy(column, column + words, top);
+                bitSelect(top, block.column(pins[1]), block.column(pins[2]), words);
+                top += words;
+                break;
+            }
+            case Instruction::AndPin:
+                bitAnd(top - words, block.column(pins[0]), words);
+                break;
+            case Instruction::OrPin:
+                bitOr(top - words, block.column(pins[0]), words);
+                break;
+            case Instruction::Not:
+                bitNot(top - words, words);
+                break;
+            case Instruction::And:
+                top -= words;
+                bitAnd(top - words, top, words);
+                break;
+            case Instruction::Or:
+                top -= words;
+                bitOr(top - words, top, words);
+                break;
+            case Instruction::If:
+                top -= 2 * words;
+                bitSelect(top - words, top, top + words, words);
+                break;
+        }
+    }
+    assert(top == scratch + words);
+    std::copy(scratch, scratch + words, out);
+}
@@ -0,0 +1,124 @@
+#ifndef GENETIC_MULTIPLEXER_BYTECODE_H
+#define GENETIC_MULTIPLEXER_BYTECODE_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "bitslice.h"
+#include "expressions.h"
+#include "genome.h"
+#include "geometry.h"
+
+/*
+ * Stack instructions in postfix order, where the operands of And, Or, and If are popped in
+ * reverse. The instructions ending in Pin or Pins are superinstructions which read terminal
+ * operands straight from the pin columns instead of pushing them first.
+ */
+enum class Instruction : std::uint8_t
+{
+    PushPin,
+    NotPin,
+    AndPins,
+    OrPins,
+    IfPins,
+    AndPin,
+    OrPin,
+    Not,
+    And,
+    Or,
+    If,
+};
+
+/* The pins are only meaningful for the instructions which read pin columns. */
+struct Operation
+{
+    Instruction instruction;
+    std::uint16_t pins[3];
+};
+
+/*
+ * A tree compiled into a flat stack program, which a single dispatch loop runs over a block of
+ * packed rows. Compiling reserves the instructions up front from the size of the tree, so it
+ * never reallocates.
+ */
+class BytecodeProgram
+{
+private:
+    std::vector<Operation> operations{};
+    int maximumStack{0};
+    void compile(const std::vector<Gene>& genes);
+    void emit(const std::vector<Gene>& genes, std::size_t& index, int& stack);
+public:
+    explicit BytecodeProgram(const std::vector<Gene>& genes);
+    explicit BytecodeProgram(const Expr& head);
+    [[nodiscard]] std::size_t size() const;
+    /* At most twice the depth of the tree plus one, since If keeps two operands waiting. */
+    [[nodiscard]] int stackDepth() const;
+    /* The scratch space must hold the block words for each entry of the deepest stack. */
+    void evaluate(const RowBlock& block, std::uint64_t* out, std::uint64_t* scratch) const;
+    /* Same as above, for a block whose words are a compile time constant. */
+    template<std::size_t Words>
+    void evaluateFixed(const RowBlock& block, std::uint64_t* out, std::uint64_t* scratch) const;
+};
+
+template<std::size_t Words>
+void BytecodeProgram::evaluateFixed(const RowBlock& block, std::uint64_t* out,
+                                    std::uint64_t* scratch) const {
+    assert(block.words == Words);
+    std::uint64_t* top = scratch;
+    for (const Operation& operation : operations) {
+        const std::uint16_t* pins = operation.pins;
+        switch (operation.instruction) {
+            case Instruction::PushPin:
+                fixedCopy<Words>(block.column(pins[0]), top);
+                top += Words;
+                break;
+            case Instruction::NotPin:
+                fixedCopy<Words>(block.column(pins[0]), top);
+                fixedNot<Words>(top);
+                top += Words;
+                break;
+            case Instruction::AndPins:
+                fixedCopy<Words>(block.column(pins[0]), top);
+                fixedAnd<Words>(top, block.column(pins[1]));
+                top += Words;
+                break;
+            case Instruction::OrPins:
+                fixedCopy<Words>(block.column(pins[0]), top);
+                fixedOr<Words>(top, block.column(pins[1]));
+                top += Words;
+                break;
+            case Instruction::IfPins:
+                fixedCopy<Words>(block.column(pins[0]), top);
+                fixedSelect<Words>(top, block.column(pins[1]), block.column(pins[2]));
+                top += Words;
+                break;
+            case Instruction::AndPin:
+                fixedAnd<Words>(top - Words, block.column(pins[0]));
+                break;
+            case Instruction::OrPin:
+                fixedOr<Words>(top - Words, block.column(pins[0]));
+                break;
+            case Instruction::Not:
+                fixedNot<Words>(top - Words);
+                break;
+            case Instruction::And:
+                top -= Words;
+                fixedAnd<Words>(top - Words, top);
+                break;
+            case Instruction::Or:
+                top -= Words;
+                fixedOr<Words>(top - Words, top);
+                break;
+            case Instruction::If:
+                top -= 2 * Words;
+                fixedSelect<Words>(top - Words, top, top + Words);
+                break;
+        }
+    }
+    assert(top == scratch + Words);
+    fixedCopy<Words>(scratch, out);
+}
+
+#endif
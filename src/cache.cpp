@@ -0,0 +1,47 @@
+#include "cache.h"
+
+FitnessCache::FitnessCache(std::size_t capacity) {
+    std::size_t size = 1;
+    while (size < capacity) {
+        size *= 2;
+    }
+    entries.resize(size, Entry{0, 0, false});
+}
+
+std::size_t FitnessCache::slot(std::uint64_t hash) const {
+    return hash & (entries.size() - 1);
+}
+
+bool FitnessCache::lookup(std::uint64_t hash, double& fitness) {
+    std::size_t index = slot(hash);
+    {
+        std::lock_guard<std::mutex> lock{stripes[index % stripeCount]};
+        const Entry& entry = entries[index];
+        if (entry.occupied && entry.hash == hash) {
+            fitness = entry.fitness;
+            hits.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    misses.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void FitnessCache::insert(std::uint64_t hash, double fitness) {
+    std::size_t index = slot(hash);
+    std::lock_guard<std::mutex> lock{stripes[index % stripeCount]};
+    entries[index] = Entry{hash, fitness, true};
+}
+
+std::uint64_t FitnessCache::hitCount() const {
+    return hits.load(std::memory_order_relaxed);
+}
+
+std::uint64_t FitnessCache::missCount() const {
+    return misses.load(std::memory_order_relaxed);
+}
+
+void FitnessCache::resetCounters() {
+    hits.store(0, std::memory_order_relaxed);
+    misses.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,40 @@
+#ifndef GENETIC_MULTIPLEXER_CACHE_H
+#define GENETIC_MULTIPLEXER_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/*
+ * A bounded map from the structural hash of a tree to its fitness. It is direct-mapped, so an
+ * insertion simply replaces whichever tree previously occupied the slot. The slots are guarded
+ * by a fixed number of lock stripes so that worker threads can share the cache.
+ */
+class FitnessCache
+{
+private:
+    struct Entry
+    {
+        std::uint64_t hash;
+        double fitness;
+        bool occupied;
+    };
+    static constexpr std::size_t stripeCount{64};
+    std::vector<Entry> entries;
+    std::mutex stripes[stripeCount];
+    std::atomic<std::uint64_t> hits{0};
+    std::atomic<std::uint64_t> misses{0};
+    [[nodiscard]] std::size_t slot(std::uint64_t hash) const;
+public:
+    /* The capacity is rounded up to a power of two. */
+    explicit FitnessCache(std::size_t capacity);
+    [[nodiscard]] bool lookup(std::uint64_t hash, double& fitness);
+    void insert(std::uint64_t hash, double fitness);
+    [[nodiscard]] std::uint64_t hitCount() const;
+    [[nodiscard]] std::uint64_t missCount() const;
+    void resetCounters();
+};
+
+#endif
@@ -0,0 +1,219 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include "checkpoint.h"
+
+constexpr char checkpointMagic[8]{'G', 'M', 'U', 'X', 'C', 'K', 'P', '2'};
+
+void writeDouble(std::vector<std::uint8_t>& buffer, double value) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    for (int i = 0; i < 8; i++) {
+        buffer.push_back(static_cast<std::uint8_t>(bits >> (8U * i)));
+    }
+}
+
+double readDouble(const std::uint8_t* data, std::size_t size, std::size_t& offset) {
+    if (size - offset < 8) {
+        throw std::runtime_error{"Truncated checkpoint"};
+    }
+    std::uint64_t bits = 0;
+    for (int i = 0; i < 8; i++) {
+        bits |= static_cast<std::uint64_t>(data[offset++]) << (8U * i);
+    }
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void writeString(std::vector<std::uint8_t>& buffer, const std::string& value) {
+    writeVarint(buffer, value.size());
+    buffer.insert(buffer.end(), value.begin(), value.end());
+}
+
+std::string readString(const std::uint8_t* data, std::size_t size, std::size_t& offset) {
+    std::uint64_t length = readVarint(data, size, offset);
+    if (length > size - offset) {
+        throw std::runtime_error{"Truncated checkpoint"};
+    }
+    std::string value{reinterpret_cast<const char*>(data + offset), length};
+    offset += length;
+    return value;
+}
+
+/* Reads a count of entries which each take at least the given number of bytes. */
+std::size_t readCount(const std::uint8_t* data, std::size_t size, std::size_t& offset,
+                      std::size_t entryBytes) {
+    std::uint64_t count = readVarint(data, size, offset);
+    if (count > (size - offset) / entryBytes) {
+        throw std::runtime_error{"Truncated checkpoint"};
+    }
+    return count;
+}
+
+std::vector<std::uint8_t> encodeCheckpoint(const Checkpoint& checkpoint) {
+    std::vector<std::uint8_t> buffer(std::begin(checkpointMagic), std::end(checkpointMagic));
+    writeVarint(buffer, checkpoint.addressPins);
+    writeVarint(buffer, checkpoint.optionsCount);
+    writeVarint(buffer, checkpoint.bestFitness.size());
+    for (double fitness : checkpoint.bestFitness) {
+        writeDouble(buffer, fitness);
+    }
+    writeString(buffer, checkpoint.prettyTree);
+    writeString(buffer, checkpoint.generatorState);
+    writeVarint(buffer, checkpoint.population.size());
+    for (std::size_t i = 0; i < checkpoint.population.size(); i++) {
+        writeDouble(buffer, checkpoint.fitness[i]);
+        encodeGenome(checkpoint.population[i], buffer);
+    }
+    return buffer;
+}
+
+Checkpoint decodeCheckpoint(const std::uint8_t* data, std::size_t size) {
+    if (size < sizeof(checkpointMagic)
+        || std::memcmp(data, checkpointMagic, sizeof(checkpointMagic)) != 0) {
+        throw std::runtime_error{"Not a checkpoint"};
+    }
+    std::size_t offset = sizeof(checkpointMagic);
+    Checkpoint checkpoint{};
+    checkpoint.addressPins = readVarint(data, size, offset);
+    checkpoint.optionsCount = readVarint(data, size, offset);
+    std::size_t generations = readCount(data, size, offset, 8);
+    for (std::size_t i = 0; i < generations; i++) {
+        checkpoint.bestFitness.emplace_back(readDouble(data, size, offset));
+    }
+    checkpoint.prettyTree = readString(data, size, offset);
+    checkpoint.generatorState = readString(data, size, offset);
+    std::size_t individuals = readCount(data, size, offset, 10);
+    checkpoint.population.reserve(individuals);
+    checkpoint.fitness.reserve(individuals);
+    for (std::size_t i = 0; i < individuals; i++) {
+        checkpoint.fitness.emplace_back(readDouble(data, size, offset));
+        Genome genome = decodeGenome(data, size, offset);
+        for (Gene gene : genome.data()) {
+            if (gene.op == Opcode::Terminal && gene.terminal >= checkpoint.optionsCount) {
+                throw std::runtime_error{"Checkpoint terminal out of range"};
+            }
+        }
+        checkpoint.population.emplace_back(std::move(genome));
+    }
+    if (offset != size) {
+        throw std::runtime_error{"Trailing bytes in checkpoint"};
+    }
+    return checkpoint;
+}
+
+std::string checkpointPath(int addressPins) {
+    return std::to_string(addressPins) + "_address_pins_checkpoint.bin";
+}
+
+Checkpoint loadCheckpoint(const std::string& path) {
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        throw std::runtime_error{"Could not open file: " + path};
+    }
+    struct stat status{};
+    if (fstat(file, &status) != 0 || status.st_size == 0) {
+        close(file);
+        throw std::runtime_error{"Could not read checkpoint: " + path};
+    }
+    auto size = static_cast<std::size_t>(status.st_size);
+    void* memory = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (memory == MAP_FAILED) {
+        throw std::runtime_error{"Could not map checkpoint: " + path};
+    }
+    try {
+        Checkpoint checkpoint = decodeCheckpoint(static_cast<const std::uint8_t*>(memory), size);
+        munmap(memory, size);
+        return checkpoint;
+    } catch (const std::runtime_error&) {
+        munmap(memory, size);
+        throw;
+    }
+}
+
+CheckpointWriter::CheckpointWriter(std::string path)
+        : path{std::move(path)}, thread{&CheckpointWriter::writeLoop, this} {}
+
+CheckpointWriter::~CheckpointWriter() {
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        stopping = true;
+    }
+    changed.notify_all();
+    thread.join();
+}
+
+void CheckpointWriter::submit(std::vector<std::uint8_t> bytes) {
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        pending = std::move(bytes);
+        hasPending = true;
+    }
+    changed.notify_all();
+}
+
+void CheckpointWriter::discard() {
+    std::unique_lock<std::mutex> lock{mutex};
+    changed.wait(lock, [this] { return !hasPending && !writing; });
+    std::remove(path.c_str());
+}
+
+void CheckpointWriter::writeLoop() {
+    std::unique_lock<std::mutex> lock{mutex};
+    while (true) {
+        changed.wait(lock, [this] { return hasPending || stopping; });
+        if (!hasPending) {
+            return;
+        }
+        std::vector<std::uint8_t> bytes = std::move(pending);
+        hasPending = false;
+        writing = true;
+        lock.unlock();
+        try {
+            writeFile(bytes);
+        } catch (const std::runtime_error& e) {
+            std::cerr << "Warn: could not write checkpoint (" << e.what() << ")" << std::endl;
+        }
+        lock.lock();
+        writing = false;
+        changed.notify_all();
+    }
+}
+
+void CheckpointWriter::writeFile(const std::vector<std::uint8_t>& bytes) const {
+    std::string temporary = path + ".tmp";
+    int file = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (file < 0) {
+        throw std::runtime_error{std::strerror(errno)};
+    }
+    std::size_t written = 0;
+    while (written < bytes.size()) {
+        ssize_t count = write(file, bytes.data() + written, bytes.size() - written);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            int error = errno;
+            close(file);
+            throw std::runtime_error{std::strerror(error)};
+        }
+        written += static_cast<std::size_t>(count);
+    }
+    bool synced = fsync(file) == 0;
+    int error = errno;
+    if (close(file) != 0 || !synced) {
+        throw std::runtime_error{std::strerror(synced ? errno : error)};
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error{std::strerror(errno)};
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef GENETIC_MULTIPLEXER_CHECKPOINT_H
+#define GENETIC_MULTIPLEXER_CHECKPOINT_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "genome.h"
+
+/*
+ * Everything needed to continue a run after the last generation it completed, which is the
+ * generation at the length of the history. Individuals which were never scored have a negative
+ * fitness.
+ */
+struct Checkpoint
+{
+    std::size_t addressPins{0};
+    std::size_t optionsCount{0};
+    std::vector<double> bestFitness{};
+    std::string prettyTree{};
+    std::string generatorState{};
+    std::vector<Genome> population{};
+    std::vector<double> fitness{};
+};
+
+/*
+ * Encodes the checkpoint behind a magic number, with counts as varints, fitness as
+ * little-endian IEEE doubles, and every tree as its encoded genome.
+ */
+std::vector<std::uint8_t> encodeCheckpoint(const Checkpoint& checkpoint);
+
+/* Checkpoints are kept next to the fitness and tree files of the run. */
+std::string checkpointPath(int addressPins);
+
+/*
+ * Maps the checkpoint file into memory and decodes it. Throws if the file cannot be read, is
+ * malformed, or refers to terminals which the problem does not have.
+ */
+Checkpoint loadCheckpoint(const std::string& path);
+
+/*
+ * Writes checkpoints to a file on a background thread, so that the generation loop only pays
+ * for encoding them. Every checkpoint is written to a temporary file which is synced and then
+ * renamed over the previous checkpoint, so a crash leaves either the old or the new checkpoint,
+ * never a torn one. If checkpoints arrive faster than they are written, only the newest waiting
+ * one is kept.
+ */
+class CheckpointWriter
+{
+private:
+    std::string path;
+    std::mutex mutex{};
+    std::condition_variable changed{};
+    std::vector<std::uint8_t> pending{};
+    bool hasPending{false};
+    bool writing{false};
+    bool stopping{false};
+    std::thread thread{};
+    void writeLoop();
+    void writeFile(const std::vector<std::uint8_t>& bytes) const;
+public:
+    explicit CheckpointWriter(std::string path);
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+    /* Finishes writing the waiting checkpoint, if any. */
+    ~CheckpointWriter();
+    void submit(std::vector<std::uint8_t> bytes);
+    /* Waits until every submitted checkpoint is written, and then removes the file. */
+    void discard();
+};
+
+#endif
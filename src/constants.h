@@ -1,11 +1,7 @@
 #ifndef GENETIC_MULTIPLEXER_CONSTANTS_H
 #define GENETIC_MULTIPLEXER_CONSTANTS_H
 
-/*
- * Setting this too high will result in higher nodes being selection more
- * frequently than deeper nodes. However, setting it too low impacts efficiency.
- */
-constexpr double arbitraryNodeSelectionAggressiveness{4.0};
+#include <cstddef>
 
 constexpr double crossoverProbability{0.94};
 
@@ -29,4 +25,87 @@ constexpr int populationSize{10'000};
 
 constexpr int selectionPerTournament{100};
 
+/*
+ * The number of 64-row words evaluated by a single walk of the tree in the bit-sliced evaluator.
+ * Larger blocks mean fewer tree walks, but the intermediate results must stay in the cache.
+ */
+constexpr std::size_t bitSlicedBlockWords{64};
+
+/*
+ * When a tree may stop being evaluated early, its bound is checked after every this many words of
+ * rows rather than only between blocks. Narrower slices notice a hopeless tree sooner, but walk
+ * the tree more often.
+ */
+constexpr std::size_t boundCheckWords{16};
+
+/*
+ * Row blocks of at most this many words are evaluated by loops inlined for their width when the
+ * pin count is specialized. Wider blocks still go through the dispatched vector kernels, which
+ * outrun the portable code that the compiler can inline.
+ */
+constexpr std::size_t inlinedBlockWords{32};
+
+/*
+ * The most words which the pin columns and target of the truth table may take together to be
+ * built once per run. Larger truth tables generate their row blocks as they are evaluated.
+ */
+constexpr std::size_t precomputedTableWords{1 << 22};
+
+/*
+ * The number of trees which evaluate each row block together when the population is scored in
+ * batches. Batches are also the unit of work handed to the threads.
+ */
+constexpr std::size_t batchEvaluationTrees{50};
+
+/*
+ * The number of trees whose fitness is remembered by structural hash. Since the cache is
+ * direct-mapped, a tree is forgotten as soon as another tree maps to the same slot.
+ */
+constexpr std::size_t fitnessCacheEntries{1 << 18};
+
+/*
+ * The default memory budget in megabytes for the subtree outputs kept by the incremental
+ * evaluator. Each output holds one bit per truth table row.
+ */
+constexpr std::size_t semanticsCacheMegabytes{256};
+
+/* By default, islands exchange their best individuals every this many generations. */
+constexpr int islandMigrationInterval{10};
+
+/* By default, this many of the best individuals of an island migrate at a time. */
+constexpr int islandMigrantCount{4};
+
+/*
+ * Once a thread's decision diagrams hold this many nodes, they are all dropped before the next
+ * tree is compiled. Each node takes twelve bytes, plus its share of the unique table.
+ */
+constexpr std::size_t bddNodeLimit{1 << 22};
+
+/* The number of if-then-else results remembered by the direct-mapped computed cache. */
+constexpr std::size_t bddComputedEntries{1 << 18};
+
+/* Sampled fitness never draws more rows than this in one generation. */
+constexpr std::size_t sampledRowsMaximum{1 << 16};
+
+/*
+ * Sampled fitness draws enough rows that the standard error of a tree's fraction of correct rows
+ * is at most this share of the standard deviation between the trees of the last generation.
+ */
+constexpr double sampleErrorShare{0.25};
+
+/* The number of genomes sent to an evaluation worker in one message. */
+constexpr std::size_t farmBatchGenomes{32};
+
+/*
+ * The number of batches each evaluation worker may have queued at once, so that its next batch
+ * has already arrived by the time it replies to the previous one.
+ */
+constexpr std::size_t farmBatchesInFlight{3};
+
+/* The random number generator of each thread refills its buffer this many words at a time. */
+constexpr std::size_t randomBufferWords{64};
+
+/* Telemetry records are collected in memory and written out once they take this many bytes. */
+constexpr std::size_t telemetryBufferBytes{1 << 16};
+
 #endif
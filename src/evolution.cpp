@@ -0,0 +1,790 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include "constants.h"
+#include "evolution.h"
+#include "migration.h"
+#include "pool.h"
+#include "simplify.h"
+#include "tournament.h"
+
+TreeLayout::Tree TreeLayout::random(const std::vector<std::string>& options, int depth) {
+    return randomNode(options, depth);
+}
+
+TreeLayout::Tree TreeLayout::copy(const Tree& tree) {
+    return tree->clone();
+}
+
+std::tuple<TreeLayout::Tree, TreeLayout::Tree>
+TreeLayout::recombine(const Tree& first, const Tree& second) {
+    auto[childOne, childTwo] = performRecombination(first.get(), second.get());
+    return std::make_tuple(simplifyOffspring(std::move(childOne)),
+                           simplifyOffspring(std::move(childTwo)));
+}
+
+TreeLayout::Tree TreeLayout::mutate(const Tree& tree, const std::vector<std::string>& options) {
+    return simplifyOffspring(performMutation(tree.get(), options));
+}
+
+double TreeLayout::fitness(const Tree& tree, const Scoring& scoring, double bound) {
+    return computeFitness(tree.get(), *scoring.table, scoring.evaluator, bound);
+}
+
+void TreeLayout::batchFitness(const std::vector<const Tree*>& trees, const Scoring& scoring,
+                              double* fitness) {
+    std::vector<const Expr*> heads{};
+    for (const Tree* tree : trees) {
+        heads.push_back(tree->get());
+    }
+    computeFitnessBatch(heads, *scoring.table, scoring.evaluator, fitness);
+}
+
+double TreeLayout::sampledFitness(const Tree& tree, RowSample& sample) {
+    return ::sampledFitness(tree.get(), sample);
+}
+
+std::uint64_t TreeLayout::hash(const Tree& tree) {
+    return tree->computeHash(0);
+}
+
+Genome TreeLayout::genome(const Tree& tree) {
+    return Genome{*tree};
+}
+
+TreeLayout::Tree TreeLayout::fromGenome(const Genome& genome,
+                                        const std::vector<std::string>& options) {
+    return genome.toExpr(options);
+}
+
+int TreeLayout::logicSize(const Tree& tree) {
+    return tree->computeLogicSize();
+}
+
+int TreeLayout::depth(const Tree& tree) {
+    return tree->computeDepth();
+}
+
+std::string TreeLayout::prettyPrint(const Tree& tree, const std::vector<std::string>&) {
+    return simplify(tree->clone())->prettyPrint();
+}
+
+LinearLayout::Tree LinearLayout::random(const std::vector<std::string>& options, int depth) {
+    return randomGenome(options.size(), depth);
+}
+
+LinearLayout::Tree LinearLayout::copy(const Tree& tree) {
+    return tree;
+}
+
+std::tuple<LinearLayout::Tree, LinearLayout::Tree>
+LinearLayout::recombine(const Tree& first, const Tree& second) {
+    return performRecombination(first, second);
+}
+
+LinearLayout::Tree LinearLayout::mutate(const Tree& tree,
+                                        const std::vector<std::string>& options) {
+    return performMutation(tree, options.size());
+}
+
+double LinearLayout::fitness(const Tree& tree, const Scoring& scoring, double bound) {
+    return computeFitness(tree, *scoring.table, scoring.evaluator, bound);
+}
+
+void LinearLayout::batchFitness(const std::vector<const Tree*>& trees, const Scoring& scoring,
+                                double* fitness) {
+    computeFitnessBatch(trees, *scoring.table, scoring.evaluator, fitness);
+}
+
+double LinearLayout::sampledFitness(const Tree& tree, RowSample& sample) {
+    return ::sampledFitness(tree, sample);
+}
+
+std::uint64_t LinearLayout::hash(const Tree& tree) {
+    return tree.computeHash();
+}
+
+Genome LinearLayout::genome(const Tree& tree) {
+    return tree;
+}
+
+LinearLayout::Tree LinearLayout::fromGenome(const Genome& genome,
+                                            const std::vector<std::string>&) {
+    return genome;
+}
+
+int LinearLayout::logicSize(const Tree& tree) {
+    return tree.computeLogicSize();
+}
+
+int LinearLayout::depth(const Tree& tree) {
+    return tree.computeDepth();
+}
+
+std::string LinearLayout::prettyPrint(const Tree& tree, const std::vector<std::string>& options) {
+    return simplify(tree.toExpr(options))->prettyPrint();
+}
+
+SharedLayout::Tree SharedLayout::random(const std::vector<std::string>& options, int depth) {
+    return randomSharedTree(options.size(), depth);
+}
+
+SharedLayout::Tree SharedLayout::copy(const Tree& tree) {
+    return tree;
+}
+
+std::tuple<SharedLayout::Tree, SharedLayout::Tree>
+SharedLayout::recombine(const Tree& first, const Tree& second) {
+    return performRecombination(first, second);
+}
+
+SharedLayout::Tree SharedLayout::mutate(const Tree& tree,
+                                        const std::vector<std::string>& options) {
+    return performMutation(tree, options.size());
+}
+
+double SharedLayout::fitness(const Tree& tree, const Scoring& scoring, double bound) {
+    if (scoring.semantics != nullptr) {
+        return scoring.semantics->computeFitness(*tree);
+    }
+    return computeFitness(*tree, *scoring.table, scoring.evaluator, bound);
+}
+
+void SharedLayout::batchFitness(const std::vector<const Tree*>& trees, const Scoring& scoring,
+                                double* fitness) {
+    std::vector<const SharedNode*> heads{};
+    for (const Tree* tree : trees) {
+        heads.push_back(&**tree);
+    }
+    computeFitnessBatch(heads, *scoring.table, scoring.evaluator, fitness);
+}
+
+double SharedLayout::sampledFitness(const Tree& tree, RowSample& sample) {
+    return ::sampledFitness(*tree, sample);
+}
+
+std::uint64_t SharedLayout::hash(const Tree& tree) {
+    return tree->computeHash();
+}
+
+Genome SharedLayout::genome(const Tree& tree) {
+    std::vector<Gene> genes{};
+    tree->appendGenes(genes);
+    return Genome{std::move(genes)};
+}
+
+SharedLayout::Tree SharedLayout::fromGenome(const Genome& genome,
+                                            const std::vector<std::string>&) {
+    return internGenes(genome.data());
+}
+
+int SharedLayout::logicSize(const Tree& tree) {
+    return tree->computeLogicSize();
+}
+
+int SharedLayout::depth(const Tree& tree) {
+    return tree->computeDepth();
+}
+
+std::string SharedLayout::prettyPrint(const Tree& tree, const std::vector<std::string>& options) {
+    return simplify(genome(tree).toExpr(options))->prettyPrint();
+}
+
+/*
+ * When sampling, draws the rows of the next generation and forgets every estimate made on the
+ * previous rows, so that the whole population is compared on the same rows.
+ */
+template<typename Tree>
+void resampleRows(std::vector<Individual<Tree>>& population, const Scoring& scoring) {
+    if (scoring.sample == nullptr) {
+        return;
+    }
+    scoring.sample->resample();
+    for (Individual<Tree>& individual : population) {
+        individual.fitness = -1;
+    }
+}
+
+/*
+ * When evaluation is farmed out or batched, scores every individual of the population which is
+ * neither already scored nor in the cache before the tournaments, so that they only ever find
+ * scored individuals. The farm gets all of them in one call, while batches of them are
+ * evaluated together, on the pool if there is one. Otherwise, individuals are scored lazily by
+ * the tournaments. Either way, scoring is timed as part of selection.
+ */
+template<typename Layout, typename Tree = typename Layout::Tree>
+void scorePopulation(std::vector<Individual<Tree>>& population, const Scoring& scoring,
+                     WorkStealingPool* pool) {
+    if (scoring.farm == nullptr && !scoring.batched) {
+        return;
+    }
+    PhaseTimer selectionTimer{scoring.counters, Phase::selection};
+    PhaseTimer evaluationTimer{scoring.counters, Phase::evaluation};
+    std::vector<Individual<Tree>*> unscored{};
+    for (Individual<Tree>& individual : population) {
+        if (individual.fitness >= 0) {
+            continue;
+        }
+        if (scoring.cache != nullptr) {
+            individual.hash = Layout::hash(individual.tree);
+            if (scoring.cache->lookup(individual.hash, individual.fitness)) {
+                continue;
+            }
+        }
+        unscored.push_back(&individual);
+    }
+    std::vector<double> fitness(unscored.size());
+    if (scoring.farm != nullptr) {
+        std::vector<Genome> genomes{};
+        for (const Individual<Tree>* individual : unscored) {
+            genomes.push_back(Layout::genome(individual->tree));
+        }
+        fitness = scoring.farm->evaluate(genomes);
+    } else {
+        auto batches = static_cast<int>(
+                (unscored.size() + batchEvaluationTrees - 1) / batchEvaluationTrees);
+        auto evaluateBatch = [&](int batch, int) {
+            std::size_t first = batch * batchEvaluationTrees;
+            std::size_t last = std::min(first + batchEvaluationTrees, unscored.size());
+            std::vector<const Tree*> trees{};
+            for (std::size_t i = first; i < last; i++) {
+                trees.push_back(&unscored[i]->tree);
+            }
+            Layout::batchFitness(trees, scoring, fitness.data() + first);
+        };
+        if (pool != nullptr) {
+            pool->run(batches, evaluateBatch);
+        } else {
+            for (int batch = 0; batch < batches; batch++) {
+                evaluateBatch(batch, 0);
+            }
+        }
+    }
+    if (scoring.counters != nullptr) {
+        scoring.counters->addExactEvaluations(unscored.size());
+    }
+    for (std::size_t i = 0; i < unscored.size(); i++) {
+        unscored[i]->fitness = fitness[i];
+        if (scoring.cache != nullptr) {
+            scoring.cache->insert(unscored[i]->hash, fitness[i]);
+        }
+    }
+}
+
+/*
+ * Restores the population, the history, and the generator of the calling thread from the
+ * checkpoint at the path, which must belong to the same problem and population size.
+ */
+template<typename Layout, typename Tree = typename Layout::Tree>
+void resumeFromCheckpoint(const std::string& path, int addressPins,
+                          const std::vector<std::string>& options,
+                          std::vector<Individual<Tree>>& population,
+                          std::vector<double>& bestFitness, std::string& prettyTree) {
+    Checkpoint checkpoint = loadCheckpoint(path);
+    bool matching = checkpoint.addressPins == static_cast<std::size_t>(addressPins)
+                    && checkpoint.optionsCount == options.size()
+                    && checkpoint.population.size() == populationSize;
+    if (!matching) {
+        throw std::runtime_error{"Checkpoint is from another problem: " + path};
+    }
+    for (std::size_t i = 0; i < checkpoint.population.size(); i++) {
+        Tree tree = Layout::fromGenome(checkpoint.population[i], options);
+        std::uint64_t hash = Layout::hash(tree);
+        population.emplace_back(Individual<Tree>{std::move(tree), hash, checkpoint.fitness[i]});
+    }
+    bestFitness = std::move(checkpoint.bestFitness);
+    prettyTree = std::move(checkpoint.prettyTree);
+    restoreGenerator(checkpoint.generatorState);
+}
+
+/* Encodes the run so far along with the generator of the calling thread. */
+template<typename Layout, typename Tree = typename Layout::Tree>
+std::vector<std::uint8_t> checkpointRun(int addressPins, const std::vector<std::string>& options,
+                                        const std::vector<Individual<Tree>>& population,
+                                        const std::vector<double>& bestFitness,
+                                        const std::string& prettyTree) {
+    Checkpoint checkpoint{static_cast<std::size_t>(addressPins), options.size(), bestFitness,
+                          prettyTree, generatorState(), {}, {}};
+    checkpoint.population.reserve(population.size());
+    checkpoint.fitness.reserve(population.size());
+    for (const Individual<Tree>& individual : population) {
+        checkpoint.population.emplace_back(Layout::genome(individual.tree));
+        checkpoint.fitness.emplace_back(individual.fitness);
+    }
+    return encodeCheckpoint(checkpoint);
+}
+
+/*
+ * Writes the record of a generation to the telemetry and starts its counters over. The island is
+ * only written if it is not negative. Islands share the caches and the count of rows skipped by
+ * bounds, so only the island which owns them writes them; the rows evaluated by any other island
+ * include the rows it skipped.
+ */
+template<typename Layout, typename Tree = typename Layout::Tree>
+void recordGeneration(TelemetryStream& telemetry, const Scoring& scoring, int generation,
+                      int island, bool ownsSharedCounters, double bestFitness, double wallSeconds,
+                      const std::vector<Individual<Tree>>& population) {
+    GenerationCounters& counters = *scoring.counters;
+    counters.addNodeCounts(takeNodeCounts());
+    counters.addSimplifiedSize(takeSimplifiedSize());
+    double rows = static_cast<double>(counters.exactEvaluationCount())
+                  * std::ldexp(1.0, static_cast<int>(scoring.optionsCount))
+                  + static_cast<double>(counters.sampledRowCount());
+    std::uint64_t skipped = 0;
+    if (scoring.bounded && ownsSharedCounters) {
+        skipped = skippedRowCount();
+        rows -= static_cast<double>(skipped);
+    }
+    std::uint64_t totalSize = 0;
+    std::uint64_t totalDepth = 0;
+    int maximumSize = 0;
+    int maximumTreeDepth = 0;
+    for (const Individual<Tree>& individual : population) {
+        int size = Layout::logicSize(individual.tree);
+        int depth = Layout::depth(individual.tree);
+        totalSize += size;
+        totalDepth += depth;
+        maximumSize = std::max(maximumSize, size);
+        maximumTreeDepth = std::max(maximumTreeDepth, depth);
+    }
+    double evaluationSeconds = counters.seconds(Phase::evaluation);
+    NodeCounts nodes = counters.nodeCounts();
+    telemetry.field("address_pins", static_cast<int>(scoring.addressPins));
+    if (island >= 0) {
+        telemetry.field("island", island);
+    }
+    telemetry.field("generation", generation);
+    telemetry.field("best_fitness", bestFitness);
+    telemetry.field("wall_seconds", wallSeconds);
+    telemetry.field("selection_seconds", counters.seconds(Phase::selection));
+    telemetry.field("evaluation_seconds", evaluationSeconds);
+    telemetry.field("variation_seconds", counters.seconds(Phase::variation));
+    telemetry.field("rows_evaluated", rows);
+    telemetry.field("rows_per_second", evaluationSeconds > 0 ? rows / evaluationSeconds : 0.0);
+    telemetry.field("node_allocations", nodes.allocations);
+    telemetry.field("node_frees", nodes.releases);
+    telemetry.field("simplified_size", counters.simplifiedSize());
+    telemetry.field("average_size", static_cast<double>(totalSize) / population.size());
+    telemetry.field("maximum_size", maximumSize);
+    telemetry.field("average_depth", static_cast<double>(totalDepth) / population.size());
+    telemetry.field("maximum_depth", maximumTreeDepth);
+    if (scoring.sample != nullptr) {
+        telemetry.field("sampled_rows", scoring.sample->rowCount());
+    }
+    if (ownsSharedCounters) {
+        if (scoring.bounded) {
+            telemetry.field("rows_skipped", skipped);
+        }
+        if (scoring.cache != nullptr) {
+            telemetry.field("cache_hits", scoring.cache->hitCount());
+            telemetry.field("cache_misses", scoring.cache->missCount());
+        }
+        if (scoring.semantics != nullptr) {
+            telemetry.field("semantics_hits", scoring.semantics->hitCount());
+            telemetry.field("semantics_misses", scoring.semantics->missCount());
+            telemetry.field("semantics_evictions", scoring.semantics->evictionCount());
+        }
+    }
+    telemetry.endRecord();
+    counters.reset();
+}
+
+/* Derives independent seeds from one seed using the SplitMix64 finalizer. */
+std::uint64_t streamSeed(std::uint64_t seed, std::uint64_t stream) {
+    std::uint64_t z = seed + (stream + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27U)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31U);
+}
+
+/*
+ * Runs the tournaments of one generation on the pool. The population is shuffled and split into
+ * disjoint tournaments, which samples without replacement just like the sequential tournaments.
+ * Every tournament seeds the generator of whichever worker runs it from the generation seed and
+ * its own index, and writes its offspring to its own slice of the next population, so the result
+ * is the same regardless of the number of threads or the order the tasks run in. The calling
+ * thread runs tournaments as well, so afterwards its generator continues from a stream of its own.
+ * Each tournament keeps its winner, and only the best winner is pretty printed once they are done.
+ */
+template<typename Layout, typename Tree = typename Layout::Tree>
+std::tuple<double, std::string>
+parallelGeneration(const Scoring& scoring, const std::vector<std::string>& options,
+                   WorkStealingPool& pool, std::vector<std::unique_ptr<GenerationArenas>>& arenas,
+                   std::vector<Individual<Tree>>& population,
+                   std::vector<Individual<Tree>>& updatedPopulation) {
+    resampleRows(population, scoring);
+    scorePopulation<Layout>(population, scoring, &pool);
+    for (std::size_t i = population.size() - 1; i > 0; i--) {
+        int j = uniformIntegerInclusiveBounds(0, static_cast<int>(i));
+        std::swap(population[i], population[j]);
+    }
+    std::uint64_t generationSeed = randomSeed();
+    int tournaments = populationSize / selectionPerTournament;
+    std::vector<double> tournamentFitness(tournaments);
+    std::vector<Individual<Tree>> tournamentWinner(tournaments);
+    pool.run(tournaments, [&](int tournament, int worker) {
+        setNodeArena(arenas.empty() ? nullptr : &arenas[worker]->nextGeneration());
+        seedGenerator(streamSeed(generationSeed, tournament));
+        int offset = tournament * selectionPerTournament;
+        auto[parentOne, parentTwo, bestParentFitness] = selectParents<Layout>(
+                scoring, population.data() + offset, selectionPerTournament);
+        {
+            PhaseTimer timer{scoring.counters, Phase::variation};
+            breed<Layout>(parentOne, parentTwo, options, updatedPopulation.data() + offset);
+        }
+        tournamentFitness[tournament] = bestParentFitness;
+        tournamentWinner[tournament] = std::move(parentOne);
+        if (scoring.counters != nullptr) {
+            scoring.counters->addNodeCounts(takeNodeCounts());
+            scoring.counters->addSimplifiedSize(takeSimplifiedSize());
+        }
+    });
+    seedGenerator(streamSeed(generationSeed, tournaments));
+    double bestFitnessIteration = 0;
+    int bestTournament = -1;
+    for (int j = 0; j < tournaments; j++) {
+        if (tournamentFitness[j] > bestFitnessIteration) {
+            bestFitnessIteration = tournamentFitness[j];
+            bestTournament = j;
+        }
+    }
+    std::string prettyTree{};
+    if (bestTournament >= 0) {
+        prettyTree = Layout::prettyPrint(tournamentWinner[bestTournament].tree, options);
+    }
+    tournamentWinner.clear();
+    population.clear();
+    return std::make_tuple(bestFitnessIteration, std::move(prettyTree));
+}
+
+/*
+ * Runs one island per thread, each evolving its own population with its own tournaments. Every
+ * migration interval, an island copies the winners of its best tournaments to the heap, since
+ * its arenas are reset under them, and pushes them to the inbox of the next island in the ring
+ * or of a random other island. Migrants which arrive replace random individuals at the start of
+ * the next generation. The islands run until any of them finds a perfect tree; the best fitness
+ * of a generation is the best over all islands which reached it.
+ */
+template<typename Layout, typename Tree = typename Layout::Tree>
+std::tuple<std::vector<double>, std::string>
+islandEvolution(const Scoring& scoring, const std::vector<std::string>& options,
+                const Options& settings, TelemetryStream* telemetry) {
+    using Inbox = MigrationQueue<Individual<Tree>>;
+    int islands = settings.islands;
+    std::vector<std::unique_ptr<Inbox>> inboxes{};
+    for (int i = 0; i < islands; i++) {
+        inboxes.emplace_back(std::make_unique<Inbox>(2 * islands * settings.migrants));
+    }
+    std::vector<std::vector<double>> histories(islands);
+    std::atomic<bool> solved{false};
+    std::mutex outputMutex{};
+    std::string prettyTree{};
+    double bestFitnessOverall = 0;
+    std::uint64_t islandSeed = randomSeed();
+    auto evolveIsland = [&](int island) {
+        seedGenerator(streamSeed(islandSeed, island));
+        static_cast<void>(takeNodeCounts());
+        static_cast<void>(takeSimplifiedSize());
+        Scoring islandScoring = scoring;
+        GenerationCounters counters{};
+        if (telemetry != nullptr) {
+            islandScoring.counters = &counters;
+        }
+        std::optional<RowSample> sample{};
+        if (scoring.sample != nullptr) {
+            sample.emplace(scoring.addressPins, scoring.optionsCount, settings.sampleRows);
+            islandScoring.sample = &*sample;
+        }
+        std::optional<GenerationArenas> arenas{};
+        if (settings.allocator != NodeAllocator::heap) {
+            arenas.emplace(settings.allocator == NodeAllocator::hugePages);
+            setNodeArena(&arenas->nextGeneration());
+        }
+        std::vector<Individual<Tree>> population{};
+        population.reserve(populationSize);
+        for (int i = 0; i < populationSize; i++) {
+            population.emplace_back(Individual<Tree>{Layout::random(options, initialDepth)});
+        }
+        if (arenas) {
+            arenas->swap();
+        }
+        int tournaments = populationSize / selectionPerTournament;
+        for (int generation = 0; !solved.load(std::memory_order_relaxed); generation++) {
+            auto start = std::chrono::steady_clock::now();
+            Individual<Tree> migrant{};
+            while (inboxes[island]->tryPop(migrant)) {
+                int index = uniformIntegerInclusiveBounds(0, populationSize - 1);
+                population[index] = std::move(migrant);
+            }
+            resampleRows(population, islandScoring);
+            scorePopulation<Layout>(population, islandScoring, nullptr);
+            if (arenas) {
+                setNodeArena(&arenas->nextGeneration());
+            }
+            bool migrating = (generation + 1) % settings.migrationInterval == 0;
+            std::vector<Individual<Tree>> winners{};
+            std::vector<Individual<Tree>> updatedPopulation(populationSize);
+            double bestFitnessIteration = 0;
+            std::string bestTree{};
+            int remaining = populationSize;
+            for (int j = 0; j < tournaments; j++) {
+                auto tuple = tournamentSelection<Layout>(islandScoring, population, remaining);
+                auto[parentOne, parentTwo, bestParentFitness] = std::move(tuple);
+                if (bestParentFitness > bestFitnessIteration) {
+                    bestFitnessIteration = bestParentFitness;
+                    bestTree = Layout::prettyPrint(parentOne.tree, options);
+                }
+                if (migrating) {
+                    setNodeArena(nullptr);
+                    Tree copy = Layout::copy(parentOne.tree);
+                    winners.emplace_back(Individual<Tree>{std::move(copy), parentOne.hash,
+                                                          parentOne.fitness});
+                    setNodeArena(arenas ? &arenas->nextGeneration() : nullptr);
+                }
+                PhaseTimer timer{islandScoring.counters, Phase::variation};
+                auto* children = updatedPopulation.data() + j * selectionPerTournament;
+                breed<Layout>(parentOne, parentTwo, options, children);
+            }
+            population = std::move(updatedPopulation);
+            if (arenas) {
+                arenas->swap();
+            }
+            if (migrating && islands > 1) {
+                auto fitter = [](const Individual<Tree>& first, const Individual<Tree>& second) {
+                    return first.fitness > second.fitness;
+                };
+                std::partial_sort(winners.begin(), winners.begin() + settings.migrants,
+                                  winners.end(), fitter);
+                for (int k = 0; k < settings.migrants; k++) {
+                    int destination = (island + 1) % islands;
+                    if (settings.topology == MigrationTopology::random) {
+                        int offset = uniformIntegerInclusiveBounds(1, islands - 1);
+                        destination = (island + offset) % islands;
+                    }
+                    static_cast<void>(inboxes[destination]->tryPush(winners[k]));
+                }
+            }
+            histories[island].emplace_back(bestFitnessIteration);
+            bool perfect = bestFitnessIteration >= 1.0 - std::numeric_limits<double>::epsilon();
+            std::lock_guard<std::mutex> lock{outputMutex};
+            if (bestFitnessIteration > bestFitnessOverall && !solved.load()) {
+                bestFitnessOverall = bestFitnessIteration;
+                prettyTree = std::move(bestTree);
+            }
+            if (perfect) {
+                solved.store(true);
+            }
+            if (telemetry != nullptr) {
+                std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+                recordGeneration<Layout>(*telemetry, islandScoring, generation, island,
+                                         island == 0, bestFitnessIteration, wall.count(),
+                                         population);
+            }
+            std::cout << bestFitnessIteration << " (island " << island;
+            if (scoring.cache != nullptr && island == 0) {
+                std::cout << ", cache hits: " << scoring.cache->hitCount() << ", misses: "
+                          << scoring.cache->missCount();
+                scoring.cache->resetCounters();
+            }
+            if (scoring.bounded && island == 0) {
+                std::cout << ", rows skipped: " << skippedRowCount();
+                resetSkippedRowCount();
+            }
+            std::cout << ")" << std::endl;
+        }
+        population.clear();
+        setNodeArena(nullptr);
+    };
+    std::vector<std::thread> threads{};
+    for (int i = 1; i < islands; i++) {
+        threads.emplace_back(evolveIsland, i);
+    }
+    evolveIsland(0);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    std::vector<double> bestFitness{};
+    for (const auto& history : histories) {
+        for (std::size_t generation = 0; generation < history.size(); generation++) {
+            if (generation == bestFitness.size()) {
+                bestFitness.emplace_back(0);
+            }
+            bestFitness[generation] = std::max(bestFitness[generation], history[generation]);
+        }
+    }
+    return std::make_tuple(std::move(bestFitness), prettyTree);
+}
+
+template<typename Layout>
+std::tuple<std::vector<double>, std::string>
+computeMultiplexer(int addressPins, const std::vector<std::string>& options,
+                   const Options& settings, TelemetryStream* telemetry) {
+    static_assert(crossoverProbability + mutationProbability <= 1.0);
+    static_assert(populationSize % selectionPerTournament == 0);
+    static_assert(selectionPerTournament % 2 == 0);
+    using Tree = typename Layout::Tree;
+    if (settings.seed) {
+        seedGenerator(*settings.seed);
+    }
+    TruthTable table{static_cast<std::size_t>(addressPins), options.size()};
+    std::optional<FitnessCache> cache{};
+    if (settings.cache) {
+        cache.emplace(fitnessCacheEntries);
+    }
+    std::optional<SemanticsCache> semantics{};
+    if (settings.evaluator == Evaluator::incremental) {
+        semantics.emplace(table, settings.semanticsMegabytes << 20U);
+    }
+    std::optional<RowSample> sample{};
+    if (settings.sampleRows > 0) {
+        sample.emplace(addressPins, options.size(), settings.sampleRows);
+    }
+    std::optional<EvaluationFarm> farm{};
+    if (settings.farmWorkers > 0 || !settings.workerAddresses.empty()) {
+        farm.emplace(settings.farmWorkers, settings.workerAddresses, addressPins, options.size(),
+                     settings.evaluator);
+    }
+    std::optional<GenerationCounters> counters{};
+    if (telemetry != nullptr) {
+        counters.emplace();
+    }
+    /*
+     * Decision diagrams and incremental evaluation never enumerate rows, and farmed out or batched
+     * trees are scored in full, so bounds only apply to the other evaluations.
+     */
+    bool bounded = settings.bounds && settings.evaluator != Evaluator::decisionDiagram
+                   && settings.evaluator != Evaluator::incremental && !farm && !settings.batch;
+    Scoring scoring{static_cast<std::size_t>(addressPins), options.size(), &table,
+                    settings.evaluator, cache ? &*cache : nullptr,
+                    semantics ? &*semantics : nullptr, farm ? &*farm : nullptr,
+                    sample ? &*sample : nullptr, bounded, settings.batch,
+                    counters ? &*counters : nullptr};
+    if (settings.islands > 1) {
+        return islandEvolution<Layout>(scoring, options, settings, telemetry);
+    }
+    static_cast<void>(takeNodeCounts());
+    static_cast<void>(takeSimplifiedSize());
+    std::vector<std::unique_ptr<GenerationArenas>> arenas{};
+    if (settings.allocator != NodeAllocator::heap) {
+        for (int i = 0; i < settings.threads; i++) {
+            bool hugePages = settings.allocator == NodeAllocator::hugePages;
+            arenas.emplace_back(std::make_unique<GenerationArenas>(hugePages));
+        }
+        setNodeArena(&arenas.front()->nextGeneration());
+    }
+    std::optional<WorkStealingPool> pool{};
+    if (settings.threads > 1) {
+        pool.emplace(settings.threads);
+    }
+    std::vector<double> bestFitness{};
+    std::string prettyTree{};
+    std::vector<Individual<Tree>> population{};
+    population.reserve(populationSize);
+    std::string checkpoint = checkpointPath(addressPins);
+    if (settings.resume && std::ifstream{checkpoint}.good()) {
+        resumeFromCheckpoint<Layout>(checkpoint, addressPins, options, population, bestFitness,
+                                     prettyTree);
+        std::cout << "* Resuming from generation " << bestFitness.size() << std::endl;
+    } else {
+        for (int i = 0; i < populationSize; i++) {
+            population.emplace_back(Individual<Tree>{Layout::random(options, initialDepth)});
+        }
+    }
+    std::optional<CheckpointWriter> checkpoints{};
+    if (settings.checkpointInterval > 0) {
+        checkpoints.emplace(checkpoint);
+    }
+    for (auto& generationArenas : arenas) {
+        generationArenas->swap();
+    }
+    do {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<Individual<Tree>> updatedPopulation(populationSize);
+        double bestFitnessIteration = 0;
+        if (pool) {
+            auto[bestParentFitness, bestTree] = parallelGeneration<Layout>(
+                    scoring, options, *pool, arenas, population, updatedPopulation);
+            bestFitnessIteration = bestParentFitness;
+            if (bestParentFitness > 0) {
+                prettyTree = std::move(bestTree);
+            }
+        } else {
+            resampleRows(population, scoring);
+            scorePopulation<Layout>(population, scoring, nullptr);
+            if (!arenas.empty()) {
+                setNodeArena(&arenas.front()->nextGeneration());
+            }
+            auto[bestParentFitness, bestTree] = sequentialGeneration<Layout>(
+                    scoring, options, population, updatedPopulation);
+            bestFitnessIteration = bestParentFitness;
+            if (bestParentFitness > 0) {
+                prettyTree = std::move(bestTree);
+            }
+        }
+        assert(population.empty());
+        assert(updatedPopulation.size() == populationSize);
+        bestFitness.emplace_back(bestFitnessIteration);
+        population = std::move(updatedPopulation);
+        for (auto& generationArenas : arenas) {
+            generationArenas->swap();
+        }
+        if (telemetry != nullptr) {
+            std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+            int generation = static_cast<int>(bestFitness.size()) - 1;
+            recordGeneration<Layout>(*telemetry, scoring, generation, -1, true,
+                                     bestFitnessIteration, wall.count(), population);
+        }
+        std::cout << bestFitnessIteration;
+        if (cache) {
+            std::cout << " (cache hits: " << cache->hitCount() << ", misses: "
+                      << cache->missCount() << ")";
+            cache->resetCounters();
+        }
+        if (scoring.bounded) {
+            std::cout << " (rows skipped: " << skippedRowCount() << ")";
+            resetSkippedRowCount();
+        }
+        if (sample) {
+            std::cout << " (sampled rows: " << sample->rowCount() << ")";
+        }
+        if (semantics) {
+            std::cout << " (semantics hits: " << semantics->hitCount() << ", misses: "
+                      << semantics->missCount() << ", evictions: " << semantics->evictionCount()
+                      << ")";
+            semantics->resetCounters();
+        }
+        std::cout << std::endl;
+        bool perfect = bestFitness.back() >= 1.0 - std::numeric_limits<double>::epsilon();
+        if (checkpoints && !perfect && bestFitness.size() % settings.checkpointInterval == 0) {
+            checkpoints->submit(checkpointRun<Layout>(addressPins, options, population,
+                                                      bestFitness, prettyTree));
+        }
+    } while (bestFitness.back() < 1.0 - std::numeric_limits<double>::epsilon());
+    if (checkpoints) {
+        checkpoints->discard();
+    }
+    setNodeArena(nullptr);
+    return std::make_tuple(std::move(bestFitness), prettyTree);
+}
+
+template std::tuple<std::vector<double>, std::string>
+computeMultiplexer<TreeLayout>(int addressPins, const std::vector<std::string>& options,
+                               const Options& settings, TelemetryStream* telemetry);
+
+template std::tuple<std::vector<double>, std::string>
+computeMultiplexer<LinearLayout>(int addressPins, const std::vector<std::string>& options,
+                                 const Options& settings, TelemetryStream* telemetry);
+
+template std::tuple<std::vector<double>, std::string>
+computeMultiplexer<SharedLayout>(int addressPins, const std::vector<std::string>& options,
+                                 const Options& settings, TelemetryStream* telemetry);
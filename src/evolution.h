@@ -0,0 +1,121 @@
+#ifndef GENETIC_MULTIPLEXER_EVOLUTION_H
+#define GENETIC_MULTIPLEXER_EVOLUTION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "cache.h"
+#include "checkpoint.h"
+#include "expressions.h"
+#include "farm.h"
+#include "fitness.h"
+#include "genome.h"
+#include "options.h"
+#include "sampling.h"
+#include "semantics.h"
+#include "shared.h"
+#include "telemetry.h"
+
+/*
+ * Everything needed to score an individual; the truth table is shared by every evaluation of the
+ * run, either cache is null when it is disabled, the farm is null unless evaluation is farmed
+ * out to worker processes, and the sample is null unless fitness is estimated from sampled rows.
+ * When sampling, the cache only holds exact fitness. When bounded, tournaments stop evaluating
+ * trees which can no longer be picked as parents. When batched, the population is scored in
+ * batches of trees before the tournaments. The counters are null unless telemetry is written.
+ */
+struct Scoring
+{
+    std::size_t addressPins;
+    std::size_t optionsCount;
+    const TruthTable* table;
+    Evaluator evaluator;
+    FitnessCache* cache;
+    SemanticsCache* semantics;
+    EvaluationFarm* farm;
+    RowSample* sample;
+    bool bounded;
+    bool batched;
+    GenerationCounters* counters;
+};
+
+/* Individuals are node trees, and variation operates on cloned trees. */
+struct TreeLayout
+{
+    using Tree = std::unique_ptr<Expr>;
+    static Tree random(const std::vector<std::string>& options, int depth);
+    static Tree copy(const Tree& tree);
+    static std::tuple<Tree, Tree> recombine(const Tree& first, const Tree& second);
+    static Tree mutate(const Tree& tree, const std::vector<std::string>& options);
+    /* Negative if the tree cannot beat the bound, as with computeFitness. */
+    static double fitness(const Tree& tree, const Scoring& scoring, double bound);
+    /* Scores the trees together without a bound, as with computeFitnessBatch. */
+    static void batchFitness(const std::vector<const Tree*>& trees, const Scoring& scoring,
+                             double* fitness);
+    static double sampledFitness(const Tree& tree, RowSample& sample);
+    static std::uint64_t hash(const Tree& tree);
+    static Genome genome(const Tree& tree);
+    static Tree fromGenome(const Genome& genome, const std::vector<std::string>& options);
+    static int logicSize(const Tree& tree);
+    static int depth(const Tree& tree);
+    static std::string prettyPrint(const Tree& tree, const std::vector<std::string>& options);
+};
+
+/* Individuals are flat genomes, and variation splices subranges of genes. */
+struct LinearLayout
+{
+    using Tree = Genome;
+    static Tree random(const std::vector<std::string>& options, int depth);
+    static Tree copy(const Tree& tree);
+    static std::tuple<Tree, Tree> recombine(const Tree& first, const Tree& second);
+    static Tree mutate(const Tree& tree, const std::vector<std::string>& options);
+    /* Negative if the tree cannot beat the bound, as with computeFitness. */
+    static double fitness(const Tree& tree, const Scoring& scoring, double bound);
+    /* Scores the trees together without a bound, as with computeFitnessBatch. */
+    static void batchFitness(const std::vector<const Tree*>& trees, const Scoring& scoring,
+                             double* fitness);
+    static double sampledFitness(const Tree& tree, RowSample& sample);
+    static std::uint64_t hash(const Tree& tree);
+    static Genome genome(const Tree& tree);
+    static Tree fromGenome(const Genome& genome, const std::vector<std::string>& options);
+    static int logicSize(const Tree& tree);
+    static int depth(const Tree& tree);
+    static std::string prettyPrint(const Tree& tree, const std::vector<std::string>& options);
+};
+
+/* Individuals share hash-consed nodes, and variation rebuilds only the path to the change. */
+struct SharedLayout
+{
+    using Tree = NodeRef;
+    static Tree random(const std::vector<std::string>& options, int depth);
+    static Tree copy(const Tree& tree);
+    static std::tuple<Tree, Tree> recombine(const Tree& first, const Tree& second);
+    static Tree mutate(const Tree& tree, const std::vector<std::string>& options);
+    /* Negative if the tree cannot beat the bound, as with computeFitness. */
+    static double fitness(const Tree& tree, const Scoring& scoring, double bound);
+    /* Scores the trees together without a bound, as with computeFitnessBatch. */
+    static void batchFitness(const std::vector<const Tree*>& trees, const Scoring& scoring,
+                             double* fitness);
+    static double sampledFitness(const Tree& tree, RowSample& sample);
+    static std::uint64_t hash(const Tree& tree);
+    static Genome genome(const Tree& tree);
+    static Tree fromGenome(const Genome& genome, const std::vector<std::string>& options);
+    static int logicSize(const Tree& tree);
+    static int depth(const Tree& tree);
+    static std::string prettyPrint(const Tree& tree, const std::vector<std::string>& options);
+};
+
+/*
+ * Evolves a population until a tree computes the multiplexer. Returns the best fitness of
+ * every generation, and the pretty printed tree of the best individual. Unless the telemetry is
+ * null, a record of the time and work of every generation is written to it.
+ */
+template<typename Layout>
+std::tuple<std::vector<double>, std::string>
+computeMultiplexer(int addressPins, const std::vector<std::string>& options,
+                   const Options& settings, TelemetryStream* telemetry);
+
+#endif
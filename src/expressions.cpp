@@ -1,21 +1,26 @@
 #include <algorithm>
 #include <cassert>
-#include <random>
 #include <stdexcept>
+#include "arena.h"
 #include "constants.h"
 #include "expressions.h"
+#include "genome.h"
 
-std::random_device seed;
-std::mt19937 generator(seed());
+/* The weights of the mutation depths, starting from zero. */
+constexpr int mutationDepthWeights[]{0, 1, 1, 2, 2, 3};
 
-int uniformIntegerInclusiveBounds(int low, int high) {
-    std::uniform_int_distribution<int> distribution(low, high);
-    return distribution(generator);
-}
-
-double uniformReal() {
-    std::uniform_real_distribution<double> distribution(0, 1);
-    return distribution(generator);
+int randomMutationDepth() {
+    int total = 0;
+    for (int weight : mutationDepthWeights) {
+        total += weight;
+    }
+    int draw = uniformIntegerInclusiveBounds(0, total - 1);
+    int depth = 0;
+    while (draw >= mutationDepthWeights[depth]) {
+        draw -= mutationDepthWeights[depth];
+        depth++;
+    }
+    return depth;
 }
 
 std::unique_ptr<Expr> randomNode(const std::vector<std::string>& terminalOptions, int depth) {
@@ -37,13 +42,65 @@ std::unique_ptr<Expr> randomNode(const std::vector<std::string>& terminalOptions
     }
 }
 
-Expr* retrieveArbitraryNode(Expr* head) {
-    double probability = arbitraryNodeSelectionAggressiveness / head->computeLogicSize();
-    Expr* arbitraryNode = nullptr;
-    while (arbitraryNode == nullptr) {
-        arbitraryNode = head->retrieveArbitraryNode(probability);
+void* Expr::operator new(std::size_t size) {
+    static_assert(alignof(If) <= alignof(std::uint64_t));
+    static_assert(alignof(Terminal) <= alignof(std::uint64_t));
+    return allocateNode(size);
+}
+
+void Expr::operator delete(void* pointer) {
+    releaseNode(pointer);
+}
+
+int Expr::computeDepth() const {
+    return depth;
+}
+
+int Expr::computeLogicSize() const {
+    return logicSize;
+}
+
+void Expr::refreshMetadata() {
+    int children = childCount();
+    depth = 0;
+    logicSize = children > 0 ? 1 : 0;
+    for (int i = 0; i < children; i++) {
+        const Expr* node = child(i);
+        depth = std::max(depth, node->depth + 1);
+        logicSize += node->logicSize;
+    }
+}
+
+/*
+ * Picks an internal node uniformly at random. The logic size counts the internal nodes of each
+ * subtree, so a single descent from the root finds the node with a random prefix-order index.
+ * Every node on the way is appended to the path, ending with the chosen node.
+ */
+Expr* retrieveArbitraryNode(Expr* head, std::vector<Expr*>& path) {
+    assert(head->computeLogicSize() > 0);
+    int index = uniformIntegerInclusiveBounds(0, head->computeLogicSize() - 1);
+    Expr* node = head;
+    path.push_back(node);
+    while (index > 0) {
+        index--;
+        for (int i = 0;; i++) {
+            Expr* next = node->child(i);
+            if (index < next->computeLogicSize()) {
+                node = next;
+                break;
+            }
+            index -= next->computeLogicSize();
+        }
+        path.push_back(node);
+    }
+    return node;
+}
+
+/* Refreshes the metadata of the nodes on the path after the subtree below them changed. */
+void refreshPath(const std::vector<Expr*>& path) {
+    for (auto node = path.rbegin(); node != path.rend(); ++node) {
+        (*node)->refreshMetadata();
     }
-    return arbitraryNode;
 }
 
 std::tuple<std::unique_ptr<Expr>, std::unique_ptr<Expr>>
@@ -51,32 +108,42 @@ performRecombination(Expr* oldFirstHead, Expr* oldSecondHead) {
     assert(oldFirstHead != nullptr && oldSecondHead != nullptr);
     std::unique_ptr<Expr> firstHeadCopy = oldFirstHead->clone();
     std::unique_ptr<Expr> secondHeadCopy = oldSecondHead->clone();
-    Expr* firstArbitraryNode = retrieveArbitraryNode(firstHeadCopy.get());
-    Expr* secondArbitraryNode = retrieveArbitraryNode(secondHeadCopy.get());
+    std::vector<Expr*> firstPath{};
+    std::vector<Expr*> secondPath{};
+    Expr* firstArbitraryNode = retrieveArbitraryNode(firstHeadCopy.get(), firstPath);
+    Expr* secondArbitraryNode = retrieveArbitraryNode(secondHeadCopy.get(), secondPath);
     std::unique_ptr<Expr> firstChild = firstArbitraryNode->ownRandomChild();
     std::unique_ptr<Expr> secondChild = secondArbitraryNode->ownRandomChild();
     firstArbitraryNode->returnChildOwnership(std::move(secondChild));
     secondArbitraryNode->returnChildOwnership(std::move(firstChild));
+    refreshPath(firstPath);
+    refreshPath(secondPath);
     return std::make_tuple(std::move(firstHeadCopy), std::move(secondHeadCopy));
 }
 
 std::unique_ptr<Expr> performMutation(Expr* head, const std::vector<std::string>& options) {
     assert(head != nullptr);
     std::unique_ptr<Expr> headCopy = head->clone();
-    Expr* arbitraryNode = retrieveArbitraryNode(headCopy.get());
+    std::vector<Expr*> path{};
+    Expr* arbitraryNode = retrieveArbitraryNode(headCopy.get(), path);
     static_cast<void>(arbitraryNode->ownRandomChild());
-    std::discrete_distribution<int> distribution{0, 1, 1, 2, 2, 3};
-    int depth = distribution(generator);
+    int depth = randomMutationDepth();
     std::unique_ptr<Expr> mutation = randomNode(options, depth);
     arbitraryNode->returnChildOwnership(std::move(mutation));
+    refreshPath(path);
     return headCopy;
 }
 
 Not::Not(const std::vector<std::string>& terminalOptions, int depth) {
     expr = randomNode(terminalOptions, depth - 1);
+    refreshMetadata();
 }
 
-Not::Not(const Not& old) {
+Not::Not(std::unique_ptr<Expr> expr) : expr{std::move(expr)} {
+    refreshMetadata();
+}
+
+Not::Not(const Not& old) : Expr{old} {
     expr = old.expr->clone();
 }
 
@@ -84,28 +151,35 @@ std::unique_ptr<Expr> Not::clone() const {
     return std::make_unique<Not>(*this);
 }
 
-int Not::computeDepth() const {
-    return 1 + expr->computeDepth();
+int Not::childCount() const {
+    return 1;
 }
 
-int Not::computeLogicSize() const {
-    return 1 + expr->computeLogicSize();
+Expr* Not::child(int index) const {
+    assert(index == 0);
+    return expr.get();
 }
 
 bool Not::evaluate(const std::vector<char>& truthTable) const {
     return !expr->evaluate(truthTable);
 }
 
+void Not::evaluate(const RowBlock& block, std::uint64_t* out, std::uint64_t* scratch) const {
+    expr->evaluate(block, out, scratch);
+    bitNot(out, block.words);
+}
+
 std::string Not::prettyPrint() const {
     return "( NOT " + expr->prettyPrint() + " )";
 }
 
-Expr* Not::retrieveArbitraryNode(double probability) {
-    double rand = uniformReal();
-    if (rand < probability) {
-        return this;
-    }
-    return expr->retrieveArbitraryNode(probability);
+void Not::appendGenes(std::vector<Gene>& genes) const {
+    genes.push_back(Gene{Opcode::Not, 0});
+    expr->appendGenes(genes);
+}
+
+std::uint64_t Not::computeHash(std::uint64_t hash) const {
+    return expr->computeHash(hashGene(hash, Gene{Opcode::Not, 0}));
 }
 
 std::unique_ptr<Expr> Not::ownRandomChild() {
@@ -116,12 +190,28 @@ void Not::returnChildOwnership(std::unique_ptr<Expr> child) {
     expr = std::move(child);
 }
 
+Gene Not::gene() const {
+    return Gene{Opcode::Not, 0};
+}
+
+std::unique_ptr<Expr> Not::replaceChild(int index, std::unique_ptr<Expr> child) {
+    assert(index == 0);
+    std::swap(expr, child);
+    return child;
+}
+
 And::And(const std::vector<std::string>& terminalOptions, int depth) {
     first = randomNode(terminalOptions, depth - 1);
     second = randomNode(terminalOptions, depth - 1);
+    refreshMetadata();
+}
+
+And::And(std::unique_ptr<Expr> first, std::unique_ptr<Expr> second)
+        : first{std::move(first)}, second{std::move(second)} {
+    refreshMetadata();
 }
 
-And::And(const And& old) {
+And::And(const And& old) : Expr{old} {
     first = old.first->clone();
     second = old.second->clone();
 }
@@ -130,36 +220,38 @@ std::unique_ptr<Expr> And::clone() const {
     return std::make_unique<And>(*this);
 }
 
-int And::computeDepth() const {
-    return 1 + std::max(first->computeDepth(), second->computeDepth());
+int And::childCount() const {
+    return 2;
 }
 
-int And::computeLogicSize() const {
-    return 1 + first->computeLogicSize() + second->computeLogicSize();
+Expr* And::child(int index) const {
+    assert(0 <= index && index < 2);
+    return index == 0 ? first.get() : second.get();
 }
 
 bool And::evaluate(const std::vector<char>& truthTable) const {
     return first->evaluate(truthTable) && second->evaluate(truthTable);
 }
 
+void And::evaluate(const RowBlock& block, std::uint64_t* out, std::uint64_t* scratch) const {
+    first->evaluate(block, out, scratch);
+    second->evaluate(block, scratch, scratch + block.words);
+    bitAnd(out, scratch, block.words);
+}
+
 std::string And::prettyPrint() const {
     return "( " + first->prettyPrint() + " AND " + second->prettyPrint() + " )";
 }
 
-Expr* And::retrieveArbitraryNode(double probability) {
-    double rand = uniformReal();
-    if (rand < probability) {
-        return this;
-    }
-    int choice = uniformIntegerInclusiveBounds(0, 1);
-    switch (choice) {
-        case 0:
-            return first->retrieveArbitraryNode(probability);
-        case 1:
-            return second->retrieveArbitraryNode(probability);
-        default:
-            assert(false);
-    }
+void And::appendGenes(std::vector<Gene>& genes) const {
+    genes.push_back(Gene{Opcode::And, 0});
+    first->appendGenes(genes);
+    second->appendGenes(genes);
+}
+
+std::uint64_t And::computeHash(std::uint64_t hash) const {
+    hash = hashGene(hash, Gene{Opcode::And, 0});
+    return second->computeHash(first->computeHash(hash));
 }
 
 std::unique_ptr<Expr> And::ownRandomChild() {
@@ -183,12 +275,28 @@ void And::returnChildOwnership(std::unique_ptr<Expr> child) {
     }
 }
 
+Gene And::gene() const {
+    return Gene{Opcode::And, 0};
+}
+
+std::unique_ptr<Expr> And::replaceChild(int index, std::unique_ptr<Expr> child) {
+    assert(0 <= index && index < 2);
+    std::swap(index == 0 ? first : second, child);
+    return child;
+}
+
 Or::Or(const std::vector<std::string>& terminalOptions, int depth) {
     first = randomNode(terminalOptions, depth - 1);
     second = randomNode(terminalOptions, depth - 1);
+    refreshMetadata();
 }
 
-Or::Or(const Or& old) {
+Or::Or(std::unique_ptr<Expr> first, std::unique_ptr<Expr> second)
+        : first{std::move(first)}, second{std::move(second)} {
+    refreshMetadata();
+}
+
+Or::Or(const Or& old) : Expr{old} {
     first = old.first->clone();
     second = old.second->clone();
 }
@@ -197,36 +305,38 @@ std::unique_ptr<Expr> Or::clone() const {
     return std::make_unique<Or>(*this);
 }
 
-int Or::computeDepth() const {
-    return 1 + std::max(first->computeDepth(), second->computeDepth());
+int Or::childCount() const {
+    return 2;
 }
 
-int Or::computeLogicSize() const {
-    return 1 + first->computeLogicSize() + second->computeLogicSize();
+Expr* Or::child(int index) const {
+    assert(0 <= index && index < 2);
+    return index == 0 ? first.get() : second.get();
 }
 
 bool Or::evaluate(const std::vector<char>& truthTable) const {
     return first->evaluate(truthTable) || second->evaluate(truthTable);
 }
 
+void Or::evaluate(const RowBlock& block, std::uint64_t* out, std::uint64_t* scratch) const {
+    first->evaluate(block, out, scratch);
+    second->evaluate(block, scratch, scratch + block.words);
+    bitOr(out, scratch, block.words);
+}
+
 std::string Or::prettyPrint() const {
     return "( " + first->prettyPrint() + " OR " + second->prettyPrint() + " )";
 }
 
-Expr* Or::retrieveArbitraryNode(double probability) {
-    double rand = uniformReal();
-    if (rand < probability) {
-        return this;
-    }
-    int choice = uniformIntegerInclusiveBounds(0, 1);
-    switch (choice) {
-        case 0:
-            return first->retrieveArbitraryNode(probability);
-        case 1:
-            return second->retrieveArbitraryNode(probability);
-        default:
-            assert(false);
-    }
+void Or::appendGenes(std::vector<Gene>& genes) const {
+    genes.push_back(Gene{Opcode::Or, 0});
+    first->appendGenes(genes);
+    second->appendGenes(genes);
+}
+
+std::uint64_t Or::computeHash(std::uint64_t hash) const {
+    hash = hashGene(hash, Gene{Opcode::Or, 0});
+    return second->computeHash(first->computeHash(hash));
 }
 
 std::unique_ptr<Expr> Or::ownRandomChild() {
@@ -250,13 +360,31 @@ void Or::returnChildOwnership(std::unique_ptr<Expr> child) {
     }
 }
 
+Gene Or::gene() const {
+    return Gene{Opcode::Or, 0};
+}
+
+std::unique_ptr<Expr> Or::replaceChild(int index, std::unique_ptr<Expr> child) {
+    assert(0 <= index && index < 2);
+    std::swap(index == 0 ? first : second, child);
+    return child;
+}
+
 If::If(const std::vector<std::string>& terminalOptions, int depth) {
     condition = randomNode(terminalOptions, depth - 1);
     trueCase = randomNode(terminalOptions, depth - 1);
     falseCase = randomNode(terminalOptions, depth - 1);
+    refreshMetadata();
+}
+
+If::If(std::unique_ptr<Expr> condition, std::unique_ptr<Expr> trueCase,
+       std::unique_ptr<Expr> falseCase)
+        : condition{std::move(condition)}, trueCase{std::move(trueCase)},
+          falseCase{std::move(falseCase)} {
+    refreshMetadata();
 }
 
-If::If(const If& old) {
+If::If(const If& old) : Expr{old} {
     condition = old.condition->clone();
     trueCase = old.trueCase->clone();
     falseCase = old.falseCase->clone();
@@ -266,14 +394,21 @@ std::unique_ptr<Expr> If::clone() const {
     return std::make_unique<If>(*this);
 }
 
-int If::computeDepth() const {
-    int partialDepth = std::max(trueCase->computeDepth(), falseCase->computeDepth());
-    return 1 + std::max(condition->computeDepth(), partialDepth);
+int If::childCount() const {
+    return 3;
 }
 
-int If::computeLogicSize() const {
-    return 1 + condition->computeLogicSize() + trueCase->computeLogicSize()
-           + falseCase->computeLogicSize();
+Expr* If::child(int index) const {
+    switch (index) {
+        case 0:
+            return condition.get();
+        case 1:
+            return trueCase.get();
+        case 2:
+            return falseCase.get();
+        default:
+            assert(false);
+    }
 }
 
 bool If::evaluate(const std::vector<char>& truthTable) const {
@@ -281,27 +416,31 @@ bool If::evaluate(const std::vector<char>& truthTable) const {
                                            : falseCase->evaluate(truthTable);
 }
 
+void If::evaluate(const RowBlock& block, std::uint64_t* out, std::uint64_t* scratch) const {
+    std::uint64_t* trueOut = scratch;
+    std::uint64_t* falseOut = scratch + block.words;
+    condition->evaluate(block, out, scratch);
+    trueCase->evaluate(block, trueOut, scratch + block.words);
+    falseCase->evaluate(block, falseOut, scratch + 2 * block.words);
+    bitSelect(out, trueOut, falseOut, block.words);
+}
+
 std::string If::prettyPrint() const {
     return "( IF " + condition->prettyPrint() + " THEN " + trueCase->prettyPrint()
            + " ELSE " + falseCase->prettyPrint() + " )";
 }
 
-Expr* If::retrieveArbitraryNode(double probability) {
-    double rand = uniformReal();
-    if (rand < probability) {
-        return this;
-    }
-    int choice = uniformIntegerInclusiveBounds(0, 2);
-    switch (choice) {
-        case 0:
-            return condition->retrieveArbitraryNode(probability);
-        case 1:
-            return trueCase->retrieveArbitraryNode(probability);
-        case 2:
-            return falseCase->retrieveArbitraryNode(probability);
-        default:
-            assert(false);
-    }
+void If::appendGenes(std::vector<Gene>& genes) const {
+    genes.push_back(Gene{Opcode::If, 0});
+    condition->appendGenes(genes);
+    trueCase->appendGenes(genes);
+    falseCase->appendGenes(genes);
+}
+
+std::uint64_t If::computeHash(std::uint64_t hash) const {
+    hash = hashGene(hash, Gene{Opcode::If, 0});
+    hash = condition->computeHash(hash);
+    return falseCase->computeHash(trueCase->computeHash(hash));
 }
 
 std::unique_ptr<Expr> If::ownRandomChild() {
@@ -333,6 +472,26 @@ void If::returnChildOwnership(std::unique_ptr<Expr> child) {
     }
 }
 
+Gene If::gene() const {
+    return Gene{Opcode::If, 0};
+}
+
+std::unique_ptr<Expr> If::replaceChild(int index, std::unique_ptr<Expr> child) {
+    switch (index) {
+        case 0:
+            std::swap(condition, child);
+            return child;
+        case 1:
+            std::swap(trueCase, child);
+            return child;
+        case 2:
+            std::swap(falseCase, child);
+            return child;
+        default:
+            assert(false);
+    }
+}
+
 Terminal::Terminal(const std::vector<std::string>& terminalOptions) {
     std::size_t high = terminalOptions.size() - 1;
     int rand = uniformIntegerInclusiveBounds(0, static_cast<int>(high));
@@ -341,7 +500,11 @@ Terminal::Terminal(const std::vector<std::string>& terminalOptions) {
     truthTableSize = terminalOptions.size();
 }
 
-Terminal::Terminal(const Terminal& old) {
+Terminal::Terminal(const std::vector<std::string>& terminalOptions, int truthTableIndex)
+        : terminal{terminalOptions.at(truthTableIndex)}, truthTableIndex{truthTableIndex},
+          truthTableSize{terminalOptions.size()} {}
+
+Terminal::Terminal(const Terminal& old) : Expr{old} {
     terminal = old.terminal;
     truthTableIndex = old.truthTableIndex;
     truthTableSize = old.truthTableSize;
@@ -351,12 +514,12 @@ std::unique_ptr<Expr> Terminal::clone() const {
     return std::make_unique<Terminal>(*this);
 }
 
-int Terminal::computeDepth() const {
+int Terminal::childCount() const {
     return 0;
 }
 
-int Terminal::computeLogicSize() const {
-    return 0;
+Expr* Terminal::child(int) const {
+    throw std::runtime_error{"A terminal has no children"};
 }
 
 bool Terminal::evaluate(const std::vector<char>& truthTable) const {
@@ -364,12 +527,22 @@ bool Terminal::evaluate(const std::vector<char>& truthTable) const {
     return truthTable[truthTableIndex];
 }
 
+void Terminal::evaluate(const RowBlock& block, std::uint64_t* out, std::uint64_t*) const {
+    assert(static_cast<std::size_t>(truthTableIndex) < truthTableSize);
+    const std::uint64_t* column = block.column(truthTableIndex);
+    std::copy(column, column + block.words, out);
+}
+
 std::string Terminal::prettyPrint() const {
     return std::string{terminal};
 }
 
-Expr* Terminal::retrieveArbitraryNode(double) {
-    return nullptr;
+void Terminal::appendGenes(std::vector<Gene>& genes) const {
+    genes.push_back(Gene{Opcode::Terminal, static_cast<std::uint16_t>(truthTableIndex)});
+}
+
+std::uint64_t Terminal::computeHash(std::uint64_t hash) const {
+    return hashGene(hash, Gene{Opcode::Terminal, static_cast<std::uint16_t>(truthTableIndex)});
 }
 
 std::unique_ptr<Expr> Terminal::ownRandomChild() {
@@ -379,3 +552,11 @@ std::unique_ptr<Expr> Terminal::ownRandomChild() {
 void Terminal::returnChildOwnership(std::unique_ptr<Expr>) {
     throw std::runtime_error{"Cannot return ownership to a terminal"};
 }
+
+Gene Terminal::gene() const {
+    return Gene{Opcode::Terminal, static_cast<std::uint16_t>(truthTableIndex)};
+}
+
+std::unique_ptr<Expr> Terminal::replaceChild(int, std::unique_ptr<Expr>) {
+    throw std::runtime_error{"A terminal has no children"};
+}
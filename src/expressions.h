@@ -1,31 +1,60 @@
 #ifndef GENETIC_MULTIPLEXER_EXPRESSIONS_H
 #define GENETIC_MULTIPLEXER_EXPRESSIONS_H
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <tuple>
 #include <vector>
+#include "bitslice.h"
+#include "random.h"
 
-int uniformIntegerInclusiveBounds(int low, int high);
+/* Draws the depth of the random subtree which replaces a mutated child. */
+int randomMutationDepth();
 
-double uniformReal();
+struct Gene;
 
 /*
  * The depth and size specifies the depth and size
  * of the entire tree below the respective node.
+ * Both are stored in the node and refreshed whenever
+ * its children change, so reading them is constant time.
  */
 class Expr
 {
+protected:
+    int depth{0};
+    int logicSize{0};
 public:
     virtual ~Expr() = default;
+    static void* operator new(std::size_t size);
+    static void operator delete(void* pointer);
     [[nodiscard]] virtual std::unique_ptr<Expr> clone() const = 0;
-    [[nodiscard]] virtual int computeDepth() const = 0;
-    [[nodiscard]] virtual int computeLogicSize() const = 0;
+    [[nodiscard]] int computeDepth() const;
+    [[nodiscard]] int computeLogicSize() const;
+    [[nodiscard]] virtual int childCount() const = 0;
+    [[nodiscard]] virtual Expr* child(int index) const = 0;
+    /* Recomputes the stored depth and size from those of the children. */
+    void refreshMetadata();
     [[nodiscard]] virtual bool evaluate(const std::vector<char>& truthTable) const = 0;
+    /*
+     * Writes the output of every row in the block to out. The scratch space must hold at least
+     * twice the block words for each level of depth below this node.
+     */
+    virtual void evaluate(const RowBlock& block, std::uint64_t* out,
+                          std::uint64_t* scratch) const = 0;
     [[nodiscard]] virtual std::string prettyPrint() const = 0;
-    [[nodiscard]] virtual Expr* retrieveArbitraryNode(double probability) = 0;
+    /* Appends the genes of this subtree in prefix order. */
+    virtual void appendGenes(std::vector<Gene>& genes) const = 0;
+    /* Continues the structural hash over the genes of this subtree in prefix order. */
+    [[nodiscard]] virtual std::uint64_t computeHash(std::uint64_t hash) const = 0;
     [[nodiscard]] virtual std::unique_ptr<Expr> ownRandomChild() = 0;
     virtual void returnChildOwnership(std::unique_ptr<Expr> child) = 0;
+    /* The gene of this node alone, which is the first of the genes of its subtree. */
+    [[nodiscard]] virtual Gene gene() const = 0;
+    /* Puts the child in place of the one at the index, returning the replaced one. */
+    [[nodiscard]] virtual std::unique_ptr<Expr> replaceChild(int index,
+                                                             std::unique_ptr<Expr> child) = 0;
 };
 
 /* Generates a random node with children based on specified depth. */
@@ -44,15 +73,22 @@ private:
     std::unique_ptr<Expr> expr;
 public:
     Not(const std::vector<std::string>& terminalOptions, int depth);
+    explicit Not(std::unique_ptr<Expr> expr);
     Not(const Not& old);
     [[nodiscard]] std::unique_ptr<Expr> clone() const override;
-    [[nodiscard]] int computeDepth() const override;
-    [[nodiscard]] int computeLogicSize() const override;
+    [[nodiscard]] int childCount() const override;
+    [[nodiscard]] Expr* child(int index) const override;
     [[nodiscard]] bool evaluate(const std::vector<char>& truthTable) const override;
+    void evaluate(const RowBlock& block, std::uint64_t* out,
+                  std::uint64_t* scratch) const override;
     [[nodiscard]] std::string prettyPrint() const override;
-    [[nodiscard]] Expr* retrieveArbitraryNode(double probability) override;
+    void appendGenes(std::vector<Gene>& genes) const override;
+    [[nodiscard]] std::uint64_t computeHash(std::uint64_t hash) const override;
     [[nodiscard]] std::unique_ptr<Expr> ownRandomChild() override;
     void returnChildOwnership(std::unique_ptr<Expr> child) override;
+    [[nodiscard]] Gene gene() const override;
+    [[nodiscard]] std::unique_ptr<Expr> replaceChild(int index,
+                                                     std::unique_ptr<Expr> child) override;
 };
 
 class And final : public Expr
@@ -62,15 +98,22 @@ private:
     std::unique_ptr<Expr> second;
 public:
     And(const std::vector<std::string>& terminalOptions, int depth);
+    And(std::unique_ptr<Expr> first, std::unique_ptr<Expr> second);
     And(const And& old);
     [[nodiscard]] std::unique_ptr<Expr> clone() const override;
-    [[nodiscard]] int computeDepth() const override;
-    [[nodiscard]] int computeLogicSize() const override;
+    [[nodiscard]] int childCount() const override;
+    [[nodiscard]] Expr* child(int index) const override;
     [[nodiscard]] bool evaluate(const std::vector<char>& truthTable) const override;
+    void evaluate(const RowBlock& block, std::uint64_t* out,
+                  std::uint64_t* scratch) const override;
     [[nodiscard]] std::string prettyPrint() const override;
-    [[nodiscard]] Expr* retrieveArbitraryNode(double probability) override;
+    void appendGenes(std::vector<Gene>& genes) const override;
+    [[nodiscard]] std::uint64_t computeHash(std::uint64_t hash) const override;
     [[nodiscard]] std::unique_ptr<Expr> ownRandomChild() override;
     void returnChildOwnership(std::unique_ptr<Expr> child) override;
+    [[nodiscard]] Gene gene() const override;
+    [[nodiscard]] std::unique_ptr<Expr> replaceChild(int index,
+                                                     std::unique_ptr<Expr> child) override;
 };
 
 class Or final : public Expr
@@ -80,15 +123,22 @@ private:
     std::unique_ptr<Expr> second;
 public:
     Or(const std::vector<std::string>& terminalOptions, int depth);
+    Or(std::unique_ptr<Expr> first, std::unique_ptr<Expr> second);
     Or(const Or& old);
     [[nodiscard]] std::unique_ptr<Expr> clone() const override;
-    [[nodiscard]] int computeDepth() const override;
-    [[nodiscard]] int computeLogicSize() const override;
+    [[nodiscard]] int childCount() const override;
+    [[nodiscard]] Expr* child(int index) const override;
     [[nodiscard]] bool evaluate(const std::vector<char>& truthTable) const override;
+    void evaluate(const RowBlock& block, std::uint64_t* out,
+                  std::uint64_t* scratch) const override;
     [[nodiscard]] std::string prettyPrint() const override;
-    [[nodiscard]] Expr* retrieveArbitraryNode(double probability) override;
+    void appendGenes(std::vector<Gene>& genes) const override;
+    [[nodiscard]] std::uint64_t computeHash(std::uint64_t hash) const override;
     [[nodiscard]] std::unique_ptr<Expr> ownRandomChild() override;
     void returnChildOwnership(std::unique_ptr<Expr> child) override;
+    [[nodiscard]] Gene gene() const override;
+    [[nodiscard]] std::unique_ptr<Expr> replaceChild(int index,
+                                                     std::unique_ptr<Expr> child) override;
 };
 
 class If final : public Expr
@@ -99,15 +149,23 @@ private:
     std::unique_ptr<Expr> falseCase;
 public:
     If(const std::vector<std::string>& terminalOptions, int depth);
+    If(std::unique_ptr<Expr> condition, std::unique_ptr<Expr> trueCase,
+       std::unique_ptr<Expr> falseCase);
     If(const If& old);
     [[nodiscard]] std::unique_ptr<Expr> clone() const override;
-    [[nodiscard]] int computeDepth() const override;
-    [[nodiscard]] int computeLogicSize() const override;
+    [[nodiscard]] int childCount() const override;
+    [[nodiscard]] Expr* child(int index) const override;
     [[nodiscard]] bool evaluate(const std::vector<char>& truthTable) const override;
+    void evaluate(const RowBlock& block, std::uint64_t* out,
+                  std::uint64_t* scratch) const override;
     [[nodiscard]] std::string prettyPrint() const override;
-    [[nodiscard]] Expr* retrieveArbitraryNode(double probability) override;
+    void appendGenes(std::vector<Gene>& genes) const override;
+    [[nodiscard]] std::uint64_t computeHash(std::uint64_t hash) const override;
     [[nodiscard]] std::unique_ptr<Expr> ownRandomChild() override;
     void returnChildOwnership(std::unique_ptr<Expr> child) override;
+    [[nodiscard]] Gene gene() const override;
+    [[nodiscard]] std::unique_ptr<Expr> replaceChild(int index,
+                                                     std::unique_ptr<Expr> child) override;
 };
 
 class Terminal final : public Expr
@@ -118,15 +176,22 @@ private:
     std::size_t truthTableSize;
 public:
     explicit Terminal(const std::vector<std::string>& terminalOptions);
+    Terminal(const std::vector<std::string>& terminalOptions, int truthTableIndex);
     Terminal(const Terminal& old);
     [[nodiscard]] std::unique_ptr<Expr> clone() const override;
-    [[nodiscard]] int computeDepth() const override;
-    [[nodiscard]] int computeLogicSize() const override;
+    [[nodiscard]] int childCount() const override;
+    [[nodiscard]] Expr* child(int index) const override;
     [[nodiscard]] bool evaluate(const std::vector<char>& truthTable) const override;
+    void evaluate(const RowBlock& block, std::uint64_t* out,
+                  std::uint64_t* scratch) const override;
     [[nodiscard]] std::string prettyPrint() const override;
-    [[nodiscard]] Expr* retrieveArbitraryNode(double probability) override;
+    void appendGenes(std::vector<Gene>& genes) const override;
+    [[nodiscard]] std::uint64_t computeHash(std::uint64_t hash) const override;
     [[nodiscard]] std::unique_ptr<Expr> ownRandomChild() override;
     void returnChildOwnership(std::unique_ptr<Expr> child) override;
+    [[nodiscard]] Gene gene() const override;
+    [[nodiscard]] std::unique_ptr<Expr> replaceChild(int index,
+                                                     std::unique_ptr<Expr> child) override;
 };
 
 #endif
@@ -0,0 +1,384 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <tuple>
+#include <unistd.h>
+#include "constants.h"
+#include "farm.h"
+
+void sendAll(int socket, const std::uint8_t* data, std::size_t size) {
+    while (size > 0) {
+        ssize_t sent = send(socket, data, size, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error{std::string{"Socket send failed: "} + std::strerror(errno)};
+        }
+        data += sent;
+        size -= sent;
+    }
+}
+
+/* Returns false if the peer closed the socket before the first byte. */
+bool receiveAll(int socket, std::uint8_t* data, std::size_t size) {
+    std::size_t total = size;
+    while (size > 0) {
+        ssize_t received = recv(socket, data, size, 0);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error{std::string{"Socket receive failed: "}
+                                     + std::strerror(errno)};
+        }
+        if (received == 0) {
+            if (size == total) {
+                return false;
+            }
+            throw std::runtime_error{"Socket closed mid-message"};
+        }
+        data += received;
+        size -= received;
+    }
+    return true;
+}
+
+/* Messages are framed by their length as four little-endian bytes. */
+void sendMessage(int socket, const std::vector<std::uint8_t>& message) {
+    std::uint8_t header[4];
+    for (unsigned i = 0; i < 4; i++) {
+        header[i] = static_cast<std::uint8_t>(message.size() >> (8 * i));
+    }
+    sendAll(socket, header, sizeof(header));
+    sendAll(socket, message.data(), message.size());
+}
+
+/* Returns false if the peer closed the socket between messages. */
+bool receiveMessage(int socket, std::vector<std::uint8_t>& message) {
+    std::uint8_t header[4];
+    if (!receiveAll(socket, header, sizeof(header))) {
+        return false;
+    }
+    std::size_t size = 0;
+    for (unsigned i = 0; i < 4; i++) {
+        size |= static_cast<std::size_t>(header[i]) << (8 * i);
+    }
+    message.resize(size);
+    if (size > 0 && !receiveAll(socket, message.data(), size)) {
+        throw std::runtime_error{"Socket closed mid-message"};
+    }
+    return true;
+}
+
+/* Splits a TCP address of the form HOST:PORT, where the port follows the last colon. */
+std::tuple<std::string, std::string> splitHostPort(const std::string& address) {
+    std::size_t colon = address.rfind(':');
+    if (colon == std::string::npos) {
+        throw std::runtime_error{"Missing port: " + address};
+    }
+    return std::make_tuple(address.substr(0, colon), address.substr(colon + 1));
+}
+
+sockaddr_un unixAddress(const std::string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error{"Socket path too long: " + path};
+    }
+    std::strcpy(address.sun_path, path.c_str());
+    return address;
+}
+
+/*
+ * Opens a socket for the address, either connecting to it or listening on it. The address is
+ * "unix:PATH" or "tcp:HOST:PORT".
+ */
+int openSocket(const std::string& address, bool listening) {
+    if (address.rfind("unix:", 0) == 0) {
+        sockaddr_un local = unixAddress(address.substr(5));
+        int socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (socket < 0) {
+            throw std::runtime_error{std::string{"Socket failed: "} + std::strerror(errno)};
+        }
+        auto* generic = reinterpret_cast<sockaddr*>(&local);
+        if (listening) {
+            unlink(local.sun_path);
+            if (bind(socket, generic, sizeof(local)) == 0 && listen(socket, SOMAXCONN) == 0) {
+                return socket;
+            }
+        } else if (connect(socket, generic, sizeof(local)) == 0) {
+            return socket;
+        }
+        int error = errno;
+        close(socket);
+        throw std::runtime_error{"Could not open " + address + ": " + std::strerror(error)};
+    }
+    if (address.rfind("tcp:", 0) == 0) {
+        auto[host, port] = splitHostPort(address.substr(4));
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = listening ? AI_PASSIVE : 0;
+        addrinfo* results = nullptr;
+        int status = getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints,
+                                 &results);
+        if (status != 0) {
+            throw std::runtime_error{"Could not resolve " + address + ": " + gai_strerror(status)};
+        }
+        for (addrinfo* result = results; result != nullptr; result = result->ai_next) {
+            int socket = ::socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+            if (socket < 0) {
+                continue;
+            }
+            if (listening) {
+                int reuse = 1;
+                setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+                if (bind(socket, result->ai_addr, result->ai_addrlen) == 0
+                    && listen(socket, SOMAXCONN) == 0) {
+                    freeaddrinfo(results);
+                    return socket;
+                }
+            } else if (connect(socket, result->ai_addr, result->ai_addrlen) == 0) {
+                int noDelay = 1;
+                setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+                freeaddrinfo(results);
+                return socket;
+            }
+            close(socket);
+        }
+        freeaddrinfo(results);
+        throw std::runtime_error{"Could not open " + address};
+    }
+    throw std::runtime_error{"Unknown address scheme: " + address};
+}
+
+/*
+ * The most address pins a worker agrees to score. Beyond six, only the decision diagram evaluator
+ * can score the multiplexer at all, and the data pin count is a shift which soon goes out of range.
+ */
+constexpr std::uint64_t largestServedPins{6};
+
+/*
+ * The problem comes over the network, so it is checked before anything is sized from it. The
+ * incremental evaluator is never farmed out, so it is not a valid problem either.
+ */
+bool validProblem(std::uint64_t addressPins, std::uint64_t optionsCount,
+                  std::uint64_t evaluatorCode) {
+    if (addressPins > largestServedPins
+        || optionsCount != addressPins + calculateCombinations(addressPins)) {
+        return false;
+    }
+    if (evaluatorCode > static_cast<std::uint64_t>(Evaluator::bytecode)) {
+        return false;
+    }
+    switch (static_cast<Evaluator>(evaluatorCode)) {
+        case Evaluator::scalar:
+        case Evaluator::bitSliced:
+        case Evaluator::decisionDiagram:
+        case Evaluator::bytecode:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/*
+ * The coordinator first sends the problem, and then batches of genomes, each answered by the
+ * fitness of its genomes as little-endian IEEE doubles. Returns once the coordinator hangs up.
+ */
+void serveConnection(int socket) {
+    std::vector<std::uint8_t> message{};
+    if (!receiveMessage(socket, message)) {
+        return;
+    }
+    std::size_t offset = 0;
+    std::size_t addressPins = readVarint(message.data(), message.size(), offset);
+    std::size_t optionsCount = readVarint(message.data(), message.size(), offset);
+    std::uint64_t evaluatorCode = readVarint(message.data(), message.size(), offset);
+    if (!validProblem(addressPins, optionsCount, evaluatorCode)) {
+        throw std::runtime_error{"Invalid problem"};
+    }
+    auto evaluator = static_cast<Evaluator>(evaluatorCode);
+    TruthTable table{addressPins, optionsCount};
+    std::vector<std::uint8_t> reply{};
+    while (receiveMessage(socket, message)) {
+        offset = 0;
+        std::uint64_t count = readVarint(message.data(), message.size(), offset);
+        reply.clear();
+        for (std::uint64_t i = 0; i < count; i++) {
+            Genome genome = decodeGenome(message.data(), message.size(), offset);
+            for (Gene gene : genome.data()) {
+                if (gene.op == Opcode::Terminal && gene.terminal >= optionsCount) {
+                    throw std::runtime_error{"Invalid terminal"};
+                }
+            }
+            double fitness = computeFitness(genome, table, evaluator, -1);
+            std::uint64_t bits;
+            std::memcpy(&bits, &fitness, sizeof(bits));
+            for (unsigned j = 0; j < 8; j++) {
+                reply.push_back(static_cast<std::uint8_t>(bits >> (8 * j)));
+            }
+        }
+        sendMessage(socket, reply);
+    }
+}
+
+EvaluationFarm::EvaluationFarm(int spawnedWorkers, const std::vector<std::string>& addresses,
+                               std::size_t addressPins, std::size_t optionsCount,
+                               Evaluator evaluator) {
+    for (int i = 0; i < spawnedWorkers; i++) {
+        int sockets[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+            throw std::runtime_error{std::string{"Socket pair failed: "} + std::strerror(errno)};
+        }
+        pid_t child = fork();
+        if (child < 0) {
+            throw std::runtime_error{std::string{"Fork failed: "} + std::strerror(errno)};
+        }
+        if (child == 0) {
+            close(sockets[0]);
+            for (const Worker& worker : workers) {
+                close(worker.socket);
+            }
+            int status = 0;
+            try {
+                serveConnection(sockets[1]);
+            } catch (const std::exception& e) {
+                status = 1;
+            }
+            _exit(status);
+        }
+        close(sockets[1]);
+        workers.push_back(Worker{sockets[0], child, {}});
+    }
+    for (const std::string& address : addresses) {
+        workers.push_back(Worker{openSocket(address, false), 0, {}});
+    }
+    std::vector<std::uint8_t> problem{};
+    writeVarint(problem, addressPins);
+    writeVarint(problem, optionsCount);
+    writeVarint(problem, static_cast<std::uint64_t>(evaluator));
+    for (const Worker& worker : workers) {
+        sendMessage(worker.socket, problem);
+    }
+}
+
+EvaluationFarm::~EvaluationFarm() {
+    for (const Worker& worker : workers) {
+        close(worker.socket);
+    }
+    for (const Worker& worker : workers) {
+        if (worker.child > 0) {
+            waitpid(worker.child, nullptr, 0);
+        }
+    }
+}
+
+/*
+ * Every worker first gets as many batches as it may have in flight. Replies come back in the
+ * order the batches were sent, so whenever a worker replies, its oldest batch is complete and
+ * the next unsent batch is sent to it right away.
+ */
+std::vector<double> EvaluationFarm::evaluate(const std::vector<Genome>& genomes) {
+    std::lock_guard<std::mutex> lock{mutex};
+    std::vector<double> fitness(genomes.size());
+    std::size_t batches = (genomes.size() + farmBatchGenomes - 1) / farmBatchGenomes;
+    std::size_t nextBatch = 0;
+    std::size_t completed = 0;
+    std::vector<std::uint8_t> message{};
+    auto sendBatch = [&](Worker& worker) {
+        std::size_t begin = nextBatch * farmBatchGenomes;
+        std::size_t end = std::min(begin + farmBatchGenomes, genomes.size());
+        message.clear();
+        writeVarint(message, end - begin);
+        for (std::size_t i = begin; i < end; i++) {
+            encodeGenome(genomes[i], message);
+        }
+        sendMessage(worker.socket, message);
+        worker.inFlight.push_back(nextBatch++);
+    };
+    for (std::size_t depth = 0; depth < farmBatchesInFlight; depth++) {
+        for (Worker& worker : workers) {
+            if (nextBatch < batches) {
+                sendBatch(worker);
+            }
+        }
+    }
+    std::vector<pollfd> polled{};
+    std::vector<Worker*> polledWorkers{};
+    while (completed < batches) {
+        polled.clear();
+        polledWorkers.clear();
+        for (Worker& worker : workers) {
+            if (!worker.inFlight.empty()) {
+                polled.push_back(pollfd{worker.socket, POLLIN, 0});
+                polledWorkers.push_back(&worker);
+            }
+        }
+        if (poll(polled.data(), polled.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error{std::string{"Poll failed: "} + std::strerror(errno)};
+        }
+        for (std::size_t i = 0; i < polled.size(); i++) {
+            if (polled[i].revents == 0) {
+                continue;
+            }
+            Worker& worker = *polledWorkers[i];
+            if (!receiveMessage(worker.socket, message)) {
+                throw std::runtime_error{"Worker hung up"};
+            }
+            std::size_t batch = worker.inFlight.front();
+            worker.inFlight.erase(worker.inFlight.begin());
+            std::size_t begin = batch * farmBatchGenomes;
+            std::size_t end = std::min(begin + farmBatchGenomes, genomes.size());
+            if (message.size() != 8 * (end - begin)) {
+                throw std::runtime_error{"Malformed reply"};
+            }
+            for (std::size_t j = begin; j < end; j++) {
+                std::uint64_t bits = 0;
+                for (unsigned k = 0; k < 8; k++) {
+                    bits |= static_cast<std::uint64_t>(message[8 * (j - begin) + k]) << (8 * k);
+                }
+                std::memcpy(&fitness[j], &bits, sizeof(bits));
+            }
+            completed++;
+            if (nextBatch < batches) {
+                sendBatch(worker);
+            }
+        }
+    }
+    return fitness;
+}
+
+void serveEvaluations(const std::string& address) {
+    int listener = openSocket(address, true);
+    while (true) {
+        int socket = accept(listener, nullptr, nullptr);
+        if (socket < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            int error = errno;
+            close(listener);
+            throw std::runtime_error{std::string{"Accept failed: "} + std::strerror(error)};
+        }
+        try {
+            serveConnection(socket);
+        } catch (const std::runtime_error& e) {
+            std::cerr << "Warn: dropping coordinator (" << e.what() << ")" << std::endl;
+        }
+        close(socket);
+    }
+}
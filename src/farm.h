@@ -0,0 +1,43 @@
+#ifndef GENETIC_MULTIPLEXER_FARM_H
+#define GENETIC_MULTIPLEXER_FARM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+#include "fitness.h"
+#include "genome.h"
+
+/*
+ * Farms fitness evaluation out to worker processes. Genomes are split into batches, and every
+ * worker is kept a few batches ahead so that it never waits for the coordinator between them.
+ * Workers are either forked locally over Unix socket pairs, or are already serving at Unix
+ * ("unix:PATH") or TCP ("tcp:HOST:PORT") addresses. Socket failures throw.
+ */
+class EvaluationFarm
+{
+private:
+    struct Worker
+    {
+        int socket;
+        pid_t child;
+        std::vector<std::size_t> inFlight;
+    };
+    std::vector<Worker> workers{};
+    std::mutex mutex{};
+public:
+    EvaluationFarm(int spawnedWorkers, const std::vector<std::string>& addresses,
+                   std::size_t addressPins, std::size_t optionsCount, Evaluator evaluator);
+    EvaluationFarm(const EvaluationFarm&) = delete;
+    EvaluationFarm& operator=(const EvaluationFarm&) = delete;
+    ~EvaluationFarm();
+    /* Returns the fitness of every genome, in order. Safe to call from several threads. */
+    [[nodiscard]] std::vector<double> evaluate(const std::vector<Genome>& genomes);
+};
+
+/* Accepts coordinators at the address one after another, evaluating their batches forever. */
+void serveEvaluations(const std::string& address);
+
+#endif
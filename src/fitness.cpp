@@ -0,0 +1,452 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+#include "bdd.h"
+#include "bytecode.h"
+#include "constants.h"
+#include "fitness.h"
+#include "geometry.h"
+
+std::atomic<std::uint64_t> skippedRows{0};
+
+/*
+ * The evaluate function is called with the truth table of each row and returns the output. Row i
+ * of the enumeration is the Gray code of i, which differs from the row before it in the pin of
+ * the lowest set bit of i. Once more rows than the allowed misses are wrong, returns the rows
+ * counted so far.
+ */
+template<typename Evaluate>
+std::size_t scalarCorrectCount(Evaluate evaluate, const TruthTable& table,
+                               std::size_t allowedMisses) {
+    std::size_t optionsCount = table.optionCount();
+    assert(calculateCombinations(table.addressPinCount())
+           == optionsCount - table.addressPinCount());
+    std::size_t combinations = calculateCombinations(optionsCount);
+    std::vector<char> truthTable(optionsCount, 0);
+    std::size_t row = 0;
+    std::size_t correct = 0;
+    for (std::size_t i = 0; i < combinations; i++) {
+        if (i - correct > allowedMisses) {
+            skippedRows.fetch_add(combinations - i, std::memory_order_relaxed);
+            return correct;
+        }
+        if (i != 0) {
+            auto offset = static_cast<std::size_t>(__builtin_ctzll(i));
+            row ^= static_cast<std::size_t>(1) << offset;
+            truthTable[(optionsCount - 1) - offset] ^= 1;
+        }
+        bool actualTruth = table.expected(row);
+        bool predictedTruth = evaluate(truthTable);
+        if (actualTruth == predictedTruth) {
+            correct++;
+        }
+    }
+    return correct;
+}
+
+/*
+ * The tree is anything with an evaluate function over a row block, either an Expr or a Genome.
+ * Just like the scalar count, returns early once more rows than the allowed misses are wrong.
+ * When there is a bound, each block is evaluated in slices so that it is checked every few words.
+ */
+template<typename Tree>
+std::size_t bitSlicedCorrectCount(const Tree& tree, int depth, const TruthTable& table,
+                                  std::size_t allowedMisses) {
+    assert(calculateCombinations(table.addressPinCount())
+           == table.optionCount() - table.addressPinCount());
+    assert(depth >= 0);
+    RowBlockGenerator generator{table};
+    std::vector<std::uint64_t> out(bitSlicedBlockWords);
+    std::vector<std::uint64_t> scratch(2 * (depth + 1) * bitSlicedBlockWords);
+    std::size_t combinations = calculateCombinations(table.optionCount());
+    std::size_t sliceWords = allowedMisses == unboundedMisses ? bitSlicedBlockWords
+                                                              : boundCheckWords;
+    std::size_t rows = 0;
+    std::size_t correct = 0;
+    for (std::size_t i = 0; i < generator.blockCount(); i++) {
+        RowBlock block = generator.generate(i);
+        for (std::size_t first = 0; first < block.words; first += sliceWords) {
+            if (rows - correct > allowedMisses) {
+                skippedRows.fetch_add(combinations - rows, std::memory_order_relaxed);
+                return correct;
+            }
+            RowBlock slice = block.slice(first, sliceWords);
+            rows += std::min(slice.words * rowsPerWord, combinations - rows);
+            tree.evaluate(slice, out.data(), scratch.data());
+            correct += countAgreement(out.data(), slice);
+        }
+    }
+    return correct;
+}
+
+/*
+ * Same as the bit-sliced count, with the block words, block count, and valid mask of the truth
+ * table fixed by the geometry, and blocks evaluated in slices of the words. The tree is either a
+ * Genome or a BytecodeProgram.
+ */
+template<typename Geometry, std::size_t Words, typename Tree>
+std::size_t fixedCorrectCount(const Tree& tree, int depth, const TruthTable& table,
+                              std::size_t allowedMisses) {
+    assert(table.addressPinCount() == static_cast<std::size_t>(Geometry::addressPins));
+    assert(depth >= 0);
+    RowBlockGenerator generator{table};
+    assert(generator.blockCount() == Geometry::blockCount);
+    std::uint64_t out[Words];
+    std::vector<std::uint64_t> scratch(2 * (depth + 1) * Words);
+    std::size_t correct = 0;
+    for (std::size_t i = 0; i < Geometry::blockCount; i++) {
+        RowBlock block = generator.generate(i);
+        for (std::size_t first = 0; first < Geometry::blockWords; first += Words) {
+            std::size_t rows = i * Geometry::blockRows + first * rowsPerWord;
+            if (rows - correct > allowedMisses) {
+                skippedRows.fetch_add(Geometry::combinations - rows, std::memory_order_relaxed);
+                return correct;
+            }
+            RowBlock slice = block.slice(first, Words);
+            tree.template evaluateFixed<Words>(slice, out, scratch.data());
+            correct += fixedAgreement<Geometry, Words>(out, slice);
+        }
+    }
+    return correct;
+}
+
+/* Runs the fixed count when the pin count of the truth table is specialized. */
+template<typename Tree>
+std::size_t specializedCorrectCount(const Tree& tree, int depth, const TruthTable& table,
+                                    std::size_t allowedMisses) {
+    std::size_t correct = 0;
+    bool specialized = withPinGeometry(table.addressPinCount(), [&](auto geometry) {
+        using Geometry = decltype(geometry);
+        if (allowedMisses == unboundedMisses) {
+            correct = fixedCorrectCount<Geometry, Geometry::blockWords>(tree, depth, table,
+                                                                        allowedMisses);
+        } else {
+            correct = fixedCorrectCount<Geometry, Geometry::sliceWords>(tree, depth, table,
+                                                                        allowedMisses);
+        }
+    });
+    if (!specialized) {
+        correct = bitSlicedCorrectCount(tree, depth, table, allowedMisses);
+    }
+    return correct;
+}
+
+std::size_t correctLogicCount(Expr* head, const TruthTable& table, std::size_t allowedMisses) {
+    auto evaluate = [head](const std::vector<char>& truthTable) {
+        return head->evaluate(truthTable);
+    };
+    return scalarCorrectCount(evaluate, table, allowedMisses);
+}
+
+std::size_t correctLogicCount(const Genome& genome, const TruthTable& table,
+                              std::size_t allowedMisses) {
+    std::vector<char> stack{};
+    auto evaluate = [&genome, &stack](const std::vector<char>& truthTable) {
+        return genome.evaluate(truthTable, stack);
+    };
+    return scalarCorrectCount(evaluate, table, allowedMisses);
+}
+
+std::size_t correctLogicCount(const SharedNode& head, const TruthTable& table,
+                              std::size_t allowedMisses) {
+    auto evaluate = [&head](const std::vector<char>& truthTable) {
+        return head.evaluate(truthTable);
+    };
+    return scalarCorrectCount(evaluate, table, allowedMisses);
+}
+
+std::size_t correctLogicCountBitSliced(Expr* head, int depth, const TruthTable& table,
+                                       std::size_t allowedMisses) {
+    return bitSlicedCorrectCount(*head, depth, table, allowedMisses);
+}
+
+std::size_t correctLogicCountBitSliced(const Genome& genome, int depth, const TruthTable& table,
+                                       std::size_t allowedMisses) {
+    return specializedCorrectCount(genome, depth, table, allowedMisses);
+}
+
+std::size_t correctLogicCountBitSliced(const SharedNode& head, int depth,
+                                       const TruthTable& table, std::size_t allowedMisses) {
+    return bitSlicedCorrectCount(head, depth, table, allowedMisses);
+}
+
+double scaleFitness(std::size_t correct, std::size_t combinations, int depth) {
+    if (correct == combinations) {
+        return 1;
+    }
+    return scaleFitness(static_cast<double>(correct) / combinations, depth);
+}
+
+double scaleFitness(double fraction, int depth) {
+    assert(disfavorDepth < maximumDepth);
+    if (fraction == 1.0) {
+        return 1;
+    }
+    double baseFitness = fraction;
+    if (depth > disfavorDepth) {
+        double factor = static_cast<double>(maximumDepth - depth) / (maximumDepth - disfavorDepth);
+        assert(0.0 <= factor && factor <= 1.0);
+        baseFitness *= factor;
+    }
+    return baseFitness;
+}
+
+std::vector<Gene> genesOf(Expr* head) {
+    std::vector<Gene> genes{};
+    head->appendGenes(genes);
+    return genes;
+}
+
+const std::vector<Gene>& genesOf(const Genome& genome) {
+    return genome.data();
+}
+
+std::vector<Gene> genesOf(const SharedNode& head) {
+    std::vector<Gene> genes{};
+    head.appendGenes(genes);
+    return genes;
+}
+
+BytecodeProgram compileProgram(Expr* head) {
+    return BytecodeProgram{*head};
+}
+
+BytecodeProgram compileProgram(const Expr& head) {
+    return BytecodeProgram{head};
+}
+
+BytecodeProgram compileProgram(const Genome& genome) {
+    return BytecodeProgram{genome.data()};
+}
+
+BytecodeProgram compileProgram(const SharedNode& head) {
+    return BytecodeProgram{genesOf(head)};
+}
+
+/*
+ * The most rows a tree of the depth can get wrong and still score above the bound. A perfect tree
+ * scores one at any depth, so with a bound below one, there is always room for no misses at all.
+ * The count is rounded in favor of the tree, so that no tree which could beat the bound is lost.
+ */
+std::size_t allowedMisses(double bound, std::size_t combinations, int depth) {
+    if (bound < 0) {
+        return unboundedMisses;
+    }
+    double factor = 1;
+    if (depth > disfavorDepth) {
+        factor = static_cast<double>(maximumDepth - depth) / (maximumDepth - disfavorDepth);
+    }
+    if (factor <= 0) {
+        return 0;
+    }
+    double minimumCorrect = std::floor(bound * combinations / factor);
+    if (minimumCorrect >= combinations) {
+        return 0;
+    }
+    return combinations - static_cast<std::size_t>(minimumCorrect);
+}
+
+/* The tree is passed on to the correct logic count overload of its type. */
+template<typename Tree>
+double treeFitness(Tree tree, int depth, const TruthTable& table, Evaluator evaluator,
+                   double bound) {
+    if (depth > maximumDepth) {
+        return 0;
+    }
+    if (evaluator == Evaluator::decisionDiagram) {
+        return scaleFitness(bddAgreement(genesOf(tree), table.addressPinCount(),
+                                         table.optionCount()), depth);
+    }
+    std::size_t combinations = calculateCombinations(table.optionCount());
+    std::size_t misses = allowedMisses(bound, combinations, depth);
+    std::size_t correct = 0;
+    switch (evaluator) {
+        case Evaluator::scalar:
+            correct = correctLogicCount(tree, table, misses);
+            break;
+        case Evaluator::bitSliced:
+        case Evaluator::incremental:
+        case Evaluator::decisionDiagram:
+            correct = correctLogicCountBitSliced(tree, depth, table, misses);
+            break;
+        case Evaluator::bytecode: {
+            BytecodeProgram program = compileProgram(tree);
+            assert(program.stackDepth() <= 2 * (depth + 1));
+            correct = specializedCorrectCount(program, depth, table, misses);
+            break;
+        }
+    }
+    if (misses != unboundedMisses && correct < combinations - misses) {
+        return -1;
+    }
+    return scaleFitness(correct, combinations, depth);
+}
+
+template<typename Tree>
+double sampledTreeFitness(const Tree& tree, int depth, RowSample& sample) {
+    if (depth > maximumDepth) {
+        return 0;
+    }
+    std::vector<std::uint64_t> out(bitSlicedBlockWords);
+    std::vector<std::uint64_t> scratch(2 * (depth + 1) * bitSlicedBlockWords);
+    std::size_t correct = 0;
+    for (std::size_t i = 0; i < sample.blockCount(); i++) {
+        RowBlock block = sample.block(i);
+        tree.evaluate(block, out.data(), scratch.data());
+        correct += countAgreement(out.data(), block);
+    }
+    double fraction = static_cast<double>(correct) / sample.rowCount();
+    sample.record(fraction);
+    return scaleFitness(fraction, depth);
+}
+
+/*
+ * Counts the correct rows of every tree, walking the row blocks in the outer loop so that each
+ * block is loaded once for the whole batch. The trees take turns on the same scratch, which is
+ * sized for the deepest of them.
+ */
+template<typename Tree>
+std::vector<std::size_t> batchCorrectCounts(const std::vector<const Tree*>& trees, int depth,
+                                            const TruthTable& table) {
+    RowBlockGenerator generator{table};
+    std::vector<std::uint64_t> out(bitSlicedBlockWords);
+    std::vector<std::uint64_t> scratch(2 * (depth + 1) * bitSlicedBlockWords);
+    std::vector<std::size_t> correct(trees.size(), 0);
+    for (std::size_t i = 0; i < generator.blockCount(); i++) {
+        RowBlock block = generator.generate(i);
+        for (std::size_t j = 0; j < trees.size(); j++) {
+            trees[j]->evaluate(block, out.data(), scratch.data());
+            correct[j] += countAgreement(out.data(), block);
+        }
+    }
+    return correct;
+}
+
+template<typename Geometry, typename Tree>
+std::vector<std::size_t> fixedBatchCorrectCounts(const std::vector<const Tree*>& trees, int depth,
+                                                 const TruthTable& table) {
+    RowBlockGenerator generator{table};
+    assert(generator.blockCount() == Geometry::blockCount);
+    constexpr std::size_t words = Geometry::blockWords;
+    std::uint64_t out[words];
+    std::vector<std::uint64_t> scratch(2 * (depth + 1) * words);
+    std::vector<std::size_t> correct(trees.size(), 0);
+    for (std::size_t i = 0; i < Geometry::blockCount; i++) {
+        RowBlock block = generator.generate(i);
+        for (std::size_t j = 0; j < trees.size(); j++) {
+            trees[j]->template evaluateFixed<Geometry::blockWords>(block, out, scratch.data());
+            correct[j] += fixedAgreement<Geometry, Geometry::blockWords>(out, block);
+        }
+    }
+    return correct;
+}
+
+/* Only a Genome or a BytecodeProgram has a fixed evaluation, which the others fall back from. */
+template<typename Tree>
+std::vector<std::size_t> specializedBatchCorrectCounts(const std::vector<const Tree*>& trees,
+                                                       int depth, const TruthTable& table) {
+    std::vector<std::size_t> correct{};
+    bool specialized = false;
+    if constexpr (std::is_same_v<Tree, Genome> || std::is_same_v<Tree, BytecodeProgram>) {
+        specialized = withPinGeometry(table.addressPinCount(), [&](auto geometry) {
+            using Geometry = decltype(geometry);
+            correct = fixedBatchCorrectCounts<Geometry>(trees, depth, table);
+        });
+    }
+    if (!specialized) {
+        correct = batchCorrectCounts(trees, depth, table);
+    }
+    return correct;
+}
+
+/* Trees deeper than the maximum depth score zero without being evaluated. */
+template<typename Tree>
+void batchTreeFitness(const std::vector<const Tree*>& trees, const TruthTable& table,
+                      Evaluator evaluator, double* fitness) {
+    assert(evaluator == Evaluator::bitSliced || evaluator == Evaluator::bytecode);
+    std::vector<const Tree*> evaluated{};
+    std::vector<std::size_t> indices{};
+    std::vector<int> depths{};
+    int deepest = 0;
+    for (std::size_t i = 0; i < trees.size(); i++) {
+        int depth = trees[i]->computeDepth();
+        fitness[i] = 0;
+        if (depth <= maximumDepth) {
+            evaluated.push_back(trees[i]);
+            indices.push_back(i);
+            depths.push_back(depth);
+            deepest = std::max(deepest, depth);
+        }
+    }
+    std::vector<std::size_t> correct{};
+    if (evaluator == Evaluator::bytecode) {
+        std::vector<BytecodeProgram> programs{};
+        std::vector<const BytecodeProgram*> pointers{};
+        programs.reserve(evaluated.size());
+        for (const Tree* tree : evaluated) {
+            programs.emplace_back(compileProgram(*tree));
+            pointers.push_back(&programs.back());
+        }
+        correct = specializedBatchCorrectCounts(pointers, deepest, table);
+    } else {
+        correct = specializedBatchCorrectCounts(evaluated, deepest, table);
+    }
+    std::size_t combinations = calculateCombinations(table.optionCount());
+    for (std::size_t i = 0; i < evaluated.size(); i++) {
+        fitness[indices[i]] = scaleFitness(correct[i], combinations, depths[i]);
+    }
+}
+
+std::uint64_t skippedRowCount() {
+    return skippedRows.load(std::memory_order_relaxed);
+}
+
+void resetSkippedRowCount() {
+    skippedRows.store(0, std::memory_order_relaxed);
+}
+
+double computeFitness(Expr* head, const TruthTable& table, Evaluator evaluator, double bound) {
+    assert(head != nullptr);
+    return treeFitness(head, head->computeDepth(), table, evaluator, bound);
+}
+
+double computeFitness(const Genome& genome, const TruthTable& table, Evaluator evaluator,
+                      double bound) {
+    return treeFitness<const Genome&>(genome, genome.computeDepth(), table, evaluator, bound);
+}
+
+double computeFitness(const SharedNode& head, const TruthTable& table, Evaluator evaluator,
+                      double bound) {
+    return treeFitness<const SharedNode&>(head, head.computeDepth(), table, evaluator, bound);
+}
+
+void computeFitnessBatch(const std::vector<const Expr*>& heads, const TruthTable& table,
+                         Evaluator evaluator, double* fitness) {
+    batchTreeFitness(heads, table, evaluator, fitness);
+}
+
+void computeFitnessBatch(const std::vector<const Genome*>& genomes, const TruthTable& table,
+                         Evaluator evaluator, double* fitness) {
+    batchTreeFitness(genomes, table, evaluator, fitness);
+}
+
+void computeFitnessBatch(const std::vector<const SharedNode*>& heads, const TruthTable& table,
+                         Evaluator evaluator, double* fitness) {
+    batchTreeFitness(heads, table, evaluator, fitness);
+}
+
+double sampledFitness(Expr* head, RowSample& sample) {
+    assert(head != nullptr);
+    return sampledTreeFitness(*head, head->computeDepth(), sample);
+}
+
+double sampledFitness(const Genome& genome, RowSample& sample) {
+    return sampledTreeFitness(genome, genome.computeDepth(), sample);
+}
+
+double sampledFitness(const SharedNode& head, RowSample& sample) {
+    return sampledTreeFitness(head, head.computeDepth(), sample);
+}
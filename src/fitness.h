@@ -0,0 +1,110 @@
+#ifndef GENETIC_MULTIPLEXER_FITNESS_H
+#define GENETIC_MULTIPLEXER_FITNESS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "bitslice.h"
+#include "expressions.h"
+#include "genome.h"
+#include "sampling.h"
+#include "shared.h"
+
+/*
+ * The incremental evaluator reuses the cached outputs of shared subtrees, which only shared trees
+ * have; any other tree is evaluated as if the evaluator were bit-sliced. The decision diagram
+ * evaluator counts the agreeing rows without enumerating them, so it is the only one which can
+ * score multiplexers with more pins than a std::size_t has bits. The bytecode evaluator compiles
+ * each tree into a stack program which runs over the same row blocks as the bit-sliced one.
+ */
+enum class Evaluator
+{
+    scalar,
+    bitSliced,
+    incremental,
+    decisionDiagram,
+    bytecode,
+};
+
+constexpr std::size_t calculateCombinations(std::size_t length) {
+    return static_cast<std::size_t>(1) << length;
+}
+
+/* Passing this as the allowed misses never stops an evaluation early. */
+constexpr std::size_t unboundedMisses{~static_cast<std::size_t>(0)};
+
+/*
+ * Evaluates the tree one truth table row at a time, visiting the rows in Gray code order so that
+ * each row only flips one pin of the previous one. Once more rows than the allowed misses are
+ * wrong, stops early and returns the rows counted so far, which is then below the combinations
+ * minus the allowed misses.
+ */
+std::size_t correctLogicCount(Expr* head, const TruthTable& table, std::size_t allowedMisses);
+
+std::size_t correctLogicCount(const Genome& genome, const TruthTable& table,
+                              std::size_t allowedMisses);
+
+std::size_t correctLogicCount(const SharedNode& head, const TruthTable& table,
+                              std::size_t allowedMisses);
+
+/* Evaluates the tree over blocks of packed rows, 64 rows per word, stopping early as above. */
+std::size_t correctLogicCountBitSliced(Expr* head, int depth, const TruthTable& table,
+                                       std::size_t allowedMisses);
+
+std::size_t correctLogicCountBitSliced(const Genome& genome, int depth, const TruthTable& table,
+                                       std::size_t allowedMisses);
+
+std::size_t correctLogicCountBitSliced(const SharedNode& head, int depth,
+                                       const TruthTable& table, std::size_t allowedMisses);
+
+/* The number of truth table rows which evaluations stopped early did not evaluate. */
+std::uint64_t skippedRowCount();
+
+void resetSkippedRowCount();
+
+/* Scales the fraction of correct rows down linearly for trees deeper than the disfavor depth. */
+double scaleFitness(std::size_t correct, std::size_t combinations, int depth);
+
+/* Same as above, given the fraction of correct rows, which is exactly one for a perfect tree. */
+double scaleFitness(double fraction, int depth);
+
+/*
+ * The bound is the fitness which the tree must beat to matter. Evaluation stops as soon as the
+ * rows already wrong rule that out, returning a negative fitness instead. A negative bound never
+ * stops evaluation, and the decision diagram evaluator ignores the bound.
+ */
+double computeFitness(Expr* head, const TruthTable& table, Evaluator evaluator, double bound);
+
+double computeFitness(const Genome& genome, const TruthTable& table, Evaluator evaluator,
+                      double bound);
+
+double computeFitness(const SharedNode& head, const TruthTable& table, Evaluator evaluator,
+                      double bound);
+
+/*
+ * Scores every tree of the batch as computeFitness would without a bound, writing the fitness of
+ * each to the same index. Every row block is evaluated by the whole batch before the next one is
+ * loaded, which keeps its pin columns in cache. Only the bit-sliced and bytecode evaluators run
+ * over row blocks, so only they can evaluate batches.
+ */
+void computeFitnessBatch(const std::vector<const Expr*>& heads, const TruthTable& table,
+                         Evaluator evaluator, double* fitness);
+
+void computeFitnessBatch(const std::vector<const Genome*>& genomes, const TruthTable& table,
+                         Evaluator evaluator, double* fitness);
+
+void computeFitnessBatch(const std::vector<const SharedNode*>& heads, const TruthTable& table,
+                         Evaluator evaluator, double* fitness);
+
+/*
+ * Estimates the fitness from the rows of the sample alone, recording the fraction of correct
+ * rows in it. The estimate is exactly one if and only if the tree is correct on every sampled
+ * row, in which case the tree still needs an exact check.
+ */
+double sampledFitness(Expr* head, RowSample& sample);
+
+double sampledFitness(const Genome& genome, RowSample& sample);
+
+double sampledFitness(const SharedNode& head, RowSample& sample);
+
+#endif
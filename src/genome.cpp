@@ -0,0 +1,365 @@
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include "constants.h"
+#include "genome.h"
+
+int arity(Opcode op) {
+    switch (op) {
+        case Opcode::Terminal:
+            return 0;
+        case Opcode::Not:
+            return 1;
+        case Opcode::And:
+        case Opcode::Or:
+            return 2;
+        case Opcode::If:
+            return 3;
+    }
+    assert(false);
+    return 0;
+}
+
+std::uint64_t hashGene(std::uint64_t hash, Gene gene) {
+    std::uint64_t value = (static_cast<std::uint64_t>(gene.op) << 16U) | gene.terminal;
+    std::uint64_t z = (hash ^ value) + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27U)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31U);
+}
+
+Genome::Genome(std::vector<Gene> genes) : genes{std::move(genes)} {
+    assert(!this->genes.empty() && subtreeEnd(0) == this->genes.size());
+}
+
+Genome::Genome(const Expr& head) {
+    head.appendGenes(genes);
+}
+
+const std::vector<Gene>& Genome::data() const {
+    return genes;
+}
+
+std::unique_ptr<Expr> buildExpr(const std::vector<Gene>& genes, std::size_t& index,
+                                const std::vector<std::string>& options) {
+    Gene gene = genes[index++];
+    switch (gene.op) {
+        case Opcode::Terminal:
+            return std::make_unique<Terminal>(options, gene.terminal);
+        case Opcode::Not:
+            return std::make_unique<Not>(buildExpr(genes, index, options));
+        case Opcode::And: {
+            auto first = buildExpr(genes, index, options);
+            auto second = buildExpr(genes, index, options);
+            return std::make_unique<And>(std::move(first), std::move(second));
+        }
+        case Opcode::Or: {
+            auto first = buildExpr(genes, index, options);
+            auto second = buildExpr(genes, index, options);
+            return std::make_unique<Or>(std::move(first), std::move(second));
+        }
+        case Opcode::If: {
+            auto condition = buildExpr(genes, index, options);
+            auto trueCase = buildExpr(genes, index, options);
+            auto falseCase = buildExpr(genes, index, options);
+            return std::make_unique<If>(std::move(condition), std::move(trueCase),
+                                        std::move(falseCase));
+        }
+    }
+    throw std::runtime_error{"Invalid opcode"};
+}
+
+std::unique_ptr<Expr> Genome::toExpr(const std::vector<std::string>& options) const {
+    std::size_t index = 0;
+    auto head = buildExpr(genes, index, options);
+    assert(index == genes.size());
+    return head;
+}
+
+std::size_t Genome::subtreeEnd(std::size_t index) const {
+    int pending = 1;
+    while (pending > 0) {
+        assert(index < genes.size());
+        pending += arity(genes[index].op) - 1;
+        index++;
+    }
+    return index;
+}
+
+int Genome::computeDepth() const {
+    std::vector<int> depths{};
+    for (auto gene = genes.rbegin(); gene != genes.rend(); ++gene) {
+        int depth = 0;
+        for (int i = 0; i < arity(gene->op); i++) {
+            depth = std::max(depth, depths.back() + 1);
+            depths.pop_back();
+        }
+        depths.push_back(depth);
+    }
+    assert(depths.size() == 1);
+    return depths.back();
+}
+
+int Genome::computeLogicSize() const {
+    auto terminals = std::count_if(genes.begin(), genes.end(), [](Gene gene) {
+        return gene.op == Opcode::Terminal;
+    });
+    return static_cast<int>(genes.size() - terminals);
+}
+
+std::uint64_t Genome::computeHash() const {
+    std::uint64_t hash = 0;
+    for (Gene gene : genes) {
+        hash = hashGene(hash, gene);
+    }
+    return hash;
+}
+
+bool Genome::evaluate(const std::vector<char>& truthTable, std::vector<char>& stack) const {
+    stack.clear();
+    for (auto gene = genes.rbegin(); gene != genes.rend(); ++gene) {
+        switch (gene->op) {
+            case Opcode::Terminal:
+                stack.push_back(truthTable[gene->terminal]);
+                break;
+            case Opcode::Not:
+                stack.back() = !stack.back();
+                break;
+            case Opcode::And: {
+                char first = stack.back();
+                stack.pop_back();
+                stack.back() = first && stack.back();
+                break;
+            }
+            case Opcode::Or: {
+                char first = stack.back();
+                stack.pop_back();
+                stack.back() = first || stack.back();
+                break;
+            }
+            case Opcode::If: {
+                char condition = stack.back();
+                stack.pop_back();
+                char trueCase = stack.back();
+                stack.pop_back();
+                stack.back() = condition ? trueCase : stack.back();
+                break;
+            }
+        }
+    }
+    assert(stack.size() == 1);
+    return stack.back();
+}
+
+/*
+ * Walks the genes backwards so that the operands of every node are already on the stack of
+ * blocks, with the first operand on top. The final result is copied into out.
+ */
+void Genome::evaluate(const RowBlock& block, std::uint64_t* out, std::uint64_t* scratch) const {
+    std::size_t words = block.words;
+    std::uint64_t* top = scratch;
+    for (auto gene = genes.rbegin(); gene != genes.rend(); ++gene) {
+        switch (gene->op) {
+            case Opcode::Terminal: {
+                const std::uint64_t* column = block.column(gene->terminal);
+                std::copy(column, column + words, top);
+                top += words;
+                break;
+            }
+            case Opcode::Not:
+                bitNot(top - words, words);
+                break;
+            case Opcode::And:
+                top -= words;
+                bitAnd(top - words, top, words);
+                break;
+            case Opcode::Or:
+                top -= words;
+                bitOr(top - words, top, words);
+                break;
+            case Opcode::If:
+                top -= 2 * words;
+                bitSelect(top + words, top, top - words, words);
+                std::copy(top + words, top + 2 * words, top - words);
+                break;
+        }
+    }
+    assert(top == scratch + words);
+    std::copy(scratch, scratch + words, out);
+}
+
+std::string prettyPrintFrom(const std::vector<Gene>& genes, std::size_t& index,
+                            const std::vector<std::string>& options) {
+    Gene gene = genes[index++];
+    switch (gene.op) {
+        case Opcode::Terminal:
+            return options.at(gene.terminal);
+        case Opcode::Not:
+            return "( NOT " + prettyPrintFrom(genes, index, options) + " )";
+        case Opcode::And: {
+            auto first = prettyPrintFrom(genes, index, options);
+            return "( " + first + " AND " + prettyPrintFrom(genes, index, options) + " )";
+        }
+        case Opcode::Or: {
+            auto first = prettyPrintFrom(genes, index, options);
+            return "( " + first + " OR " + prettyPrintFrom(genes, index, options) + " )";
+        }
+        case Opcode::If: {
+            auto condition = prettyPrintFrom(genes, index, options);
+            auto trueCase = prettyPrintFrom(genes, index, options);
+            auto falseCase = prettyPrintFrom(genes, index, options);
+            return "( IF " + condition + " THEN " + trueCase + " ELSE " + falseCase + " )";
+        }
+    }
+    throw std::runtime_error{"Invalid opcode"};
+}
+
+std::string Genome::prettyPrint(const std::vector<std::string>& options) const {
+    std::size_t index = 0;
+    auto pretty = prettyPrintFrom(genes, index, options);
+    assert(index == genes.size());
+    return pretty;
+}
+
+std::size_t Genome::retrieveArbitraryNode() const {
+    assert(genes.front().op != Opcode::Terminal);
+    int remaining = uniformIntegerInclusiveBounds(0, computeLogicSize() - 1);
+    for (std::size_t index = 0;; index++) {
+        if (genes[index].op != Opcode::Terminal && remaining-- == 0) {
+            return index;
+        }
+    }
+}
+
+std::size_t Genome::randomChild(std::size_t index) const {
+    int childCount = arity(genes[index].op);
+    assert(childCount > 0);
+    int choice = uniformIntegerInclusiveBounds(0, childCount - 1);
+    std::size_t child = index + 1;
+    for (int i = 0; i < choice; i++) {
+        child = subtreeEnd(child);
+    }
+    return child;
+}
+
+Genome Genome::splice(std::size_t start, std::size_t end, const Gene* otherStart,
+                      const Gene* otherEnd) const {
+    assert(start < end && end <= genes.size());
+    std::vector<Gene> spliced{};
+    spliced.reserve(genes.size() - (end - start) + (otherEnd - otherStart));
+    spliced.insert(spliced.end(), genes.begin(), genes.begin() + start);
+    spliced.insert(spliced.end(), otherStart, otherEnd);
+    spliced.insert(spliced.end(), genes.begin() + end, genes.end());
+    return Genome{std::move(spliced)};
+}
+
+void appendRandomGenes(std::vector<Gene>& genes, std::size_t optionsCount, int depth) {
+    if (depth == 0) {
+        int terminal = uniformIntegerInclusiveBounds(0, static_cast<int>(optionsCount) - 1);
+        genes.push_back(Gene{Opcode::Terminal, static_cast<std::uint16_t>(terminal)});
+        return;
+    }
+    constexpr Opcode operators[]{Opcode::Not, Opcode::And, Opcode::Or, Opcode::If};
+    Opcode op = operators[uniformIntegerInclusiveBounds(0, 3)];
+    genes.push_back(Gene{op, 0});
+    for (int i = 0; i < arity(op); i++) {
+        appendRandomGenes(genes, optionsCount, depth - 1);
+    }
+}
+
+Genome randomGenome(std::size_t optionsCount, int depth) {
+    std::vector<Gene> genes{};
+    appendRandomGenes(genes, optionsCount, depth);
+    return Genome{std::move(genes)};
+}
+
+std::tuple<Genome, Genome> performRecombination(const Genome& first, const Genome& second) {
+    std::size_t firstStart = first.randomChild(first.retrieveArbitraryNode());
+    std::size_t secondStart = second.randomChild(second.retrieveArbitraryNode());
+    std::size_t firstEnd = first.subtreeEnd(firstStart);
+    std::size_t secondEnd = second.subtreeEnd(secondStart);
+    const Gene* firstGenes = first.data().data();
+    const Gene* secondGenes = second.data().data();
+    Genome firstChild = first.splice(firstStart, firstEnd, secondGenes + secondStart,
+                                     secondGenes + secondEnd);
+    Genome secondChild = second.splice(secondStart, secondEnd, firstGenes + firstStart,
+                                       firstGenes + firstEnd);
+    return std::make_tuple(std::move(firstChild), std::move(secondChild));
+}
+
+Genome performMutation(const Genome& genome, std::size_t optionsCount) {
+    std::size_t start = genome.randomChild(genome.retrieveArbitraryNode());
+    std::size_t end = genome.subtreeEnd(start);
+    std::vector<Gene> mutation{};
+    appendRandomGenes(mutation, optionsCount, randomMutationDepth());
+    return genome.splice(start, end, mutation.data(), mutation.data() + mutation.size());
+}
+
+/* Operators take the codes below the first terminal code. */
+constexpr std::uint64_t firstTerminalCode{4};
+
+void writeVarint(std::vector<std::uint8_t>& buffer, std::uint64_t value) {
+    while (value >= 0x80U) {
+        buffer.push_back(static_cast<std::uint8_t>(value | 0x80U));
+        value >>= 7U;
+    }
+    buffer.push_back(static_cast<std::uint8_t>(value));
+}
+
+std::uint64_t readVarint(const std::uint8_t* data, std::size_t size, std::size_t& offset) {
+    std::uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (offset == size) {
+            throw std::runtime_error{"Truncated varint"};
+        }
+        std::uint8_t byte = data[offset++];
+        value |= static_cast<std::uint64_t>(byte & 0x7FU) << shift;
+        if ((byte & 0x80U) == 0) {
+            return value;
+        }
+    }
+    throw std::runtime_error{"Overlong varint"};
+}
+
+void encodeGenome(const Genome& genome, std::vector<std::uint8_t>& buffer) {
+    const std::vector<Gene>& genes = genome.data();
+    writeVarint(buffer, genes.size());
+    for (Gene gene : genes) {
+        if (gene.op == Opcode::Terminal) {
+            writeVarint(buffer, firstTerminalCode + gene.terminal);
+        } else {
+            writeVarint(buffer, static_cast<std::uint64_t>(gene.op) - 1);
+        }
+    }
+}
+
+Genome decodeGenome(const std::uint8_t* data, std::size_t size, std::size_t& offset) {
+    std::uint64_t count = readVarint(data, size, offset);
+    if (count == 0 || count > size - offset) {
+        throw std::runtime_error{"Invalid gene count"};
+    }
+    std::vector<Gene> genes{};
+    genes.reserve(count);
+    std::int64_t pending = 1;
+    for (std::uint64_t i = 0; i < count; i++) {
+        if (pending == 0) {
+            throw std::runtime_error{"Genes past the end of the tree"};
+        }
+        std::uint64_t code = readVarint(data, size, offset);
+        Gene gene{Opcode::Terminal, 0};
+        if (code >= firstTerminalCode) {
+            if (code - firstTerminalCode > UINT16_MAX) {
+                throw std::runtime_error{"Invalid terminal"};
+            }
+            gene.terminal = static_cast<std::uint16_t>(code - firstTerminalCode);
+        } else {
+            gene.op = static_cast<Opcode>(code + 1);
+        }
+        pending += arity(gene.op) - 1;
+        genes.push_back(gene);
+    }
+    if (pending != 0) {
+        throw std::runtime_error{"Truncated tree"};
+    }
+    return Genome{std::move(genes)};
+}
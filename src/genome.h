@@ -0,0 +1,134 @@
+#ifndef GENETIC_MULTIPLEXER_GENOME_H
+#define GENETIC_MULTIPLEXER_GENOME_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "bitslice.h"
+#include "expressions.h"
+#include "geometry.h"
+
+enum class Opcode : std::uint8_t
+{
+    Terminal,
+    Not,
+    And,
+    Or,
+    If,
+};
+
+/* The terminal index is only meaningful for terminal genes. */
+struct Gene
+{
+    Opcode op;
+    std::uint16_t terminal;
+};
+
+int arity(Opcode op);
+
+/*
+ * Folds the gene into a running structural hash. Hashing every gene of a tree in prefix order
+ * gives the same hash whether the tree is an Expr or a Genome.
+ */
+std::uint64_t hashGene(std::uint64_t hash, Gene gene);
+
+/*
+ * A tree stored as a contiguous prefix-order array of genes, so that every subtree is a
+ * contiguous subrange starting at its root. The depth and logic size match those of the
+ * equivalent expression tree.
+ */
+class Genome
+{
+private:
+    std::vector<Gene> genes;
+public:
+    Genome() = default;
+    explicit Genome(std::vector<Gene> genes);
+    explicit Genome(const Expr& head);
+    [[nodiscard]] const std::vector<Gene>& data() const;
+    [[nodiscard]] std::unique_ptr<Expr> toExpr(const std::vector<std::string>& options) const;
+    /* Returns one past the last gene of the subtree rooted at the index. */
+    [[nodiscard]] std::size_t subtreeEnd(std::size_t index) const;
+    [[nodiscard]] int computeDepth() const;
+    [[nodiscard]] int computeLogicSize() const;
+    [[nodiscard]] std::uint64_t computeHash() const;
+    /* The stack holds intermediate results and is passed in so it is allocated only once. */
+    [[nodiscard]] bool evaluate(const std::vector<char>& truthTable,
+                                std::vector<char>& stack) const;
+    /* The scratch space must hold twice the block words for each level of depth plus two. */
+    void evaluate(const RowBlock& block, std::uint64_t* out, std::uint64_t* scratch) const;
+    /* Same as above, for a block whose words are a compile time constant. */
+    template<std::size_t Words>
+    void evaluateFixed(const RowBlock& block, std::uint64_t* out, std::uint64_t* scratch) const;
+    [[nodiscard]] std::string prettyPrint(const std::vector<std::string>& options) const;
+    /* Picks an internal node uniformly at random, just like the node trees do. */
+    [[nodiscard]] std::size_t retrieveArbitraryNode() const;
+    /* Picks a child of the internal node at the index, returning the start of its subtree. */
+    [[nodiscard]] std::size_t randomChild(std::size_t index) const;
+    /* Returns a copy where the subrange [start, end) is replaced by the other subrange. */
+    [[nodiscard]] Genome splice(std::size_t start, std::size_t end, const Gene* otherStart,
+                                const Gene* otherEnd) const;
+};
+
+template<std::size_t Words>
+void Genome::evaluateFixed(const RowBlock& block, std::uint64_t* out,
+                           std::uint64_t* scratch) const {
+    assert(block.words == Words);
+    std::uint64_t* top = scratch;
+    for (auto gene = genes.rbegin(); gene != genes.rend(); ++gene) {
+        switch (gene->op) {
+            case Opcode::Terminal:
+                fixedCopy<Words>(block.column(gene->terminal), top);
+                top += Words;
+                break;
+            case Opcode::Not:
+                fixedNot<Words>(top - Words);
+                break;
+            case Opcode::And:
+                top -= Words;
+                fixedAnd<Words>(top - Words, top);
+                break;
+            case Opcode::Or:
+                top -= Words;
+                fixedOr<Words>(top - Words, top);
+                break;
+            case Opcode::If:
+                top -= 2 * Words;
+                fixedSelect<Words>(top + Words, top, top - Words);
+                fixedCopy<Words>(top + Words, top - Words);
+                break;
+        }
+    }
+    assert(top == scratch + Words);
+    fixedCopy<Words>(scratch, out);
+}
+
+/* Generates a random genome with the same distribution as randomNode. */
+Genome randomGenome(std::size_t optionsCount, int depth);
+
+/* Swaps a random child subrange between copies of both genomes. */
+std::tuple<Genome, Genome> performRecombination(const Genome& first, const Genome& second);
+
+/* Replaces a random child subrange of a copy of the genome by a random subtree. */
+Genome performMutation(const Genome& genome, std::size_t optionsCount);
+
+/* Appends the value in seven bit groups, least significant first, flagging all but the last. */
+void writeVarint(std::vector<std::uint8_t>& buffer, std::uint64_t value);
+
+/* Reads a varint at the offset and advances past it. Throws if the bytes end before it does. */
+std::uint64_t readVarint(const std::uint8_t* data, std::size_t size, std::size_t& offset);
+
+/*
+ * Appends the gene count followed by one varint per gene, where operators take the codes below
+ * four and terminal i takes the code four plus i, so small trees take about a byte per gene.
+ */
+void encodeGenome(const Genome& genome, std::vector<std::uint8_t>& buffer);
+
+/* Decodes a genome at the offset and advances past it. Throws unless it is a whole tree. */
+Genome decodeGenome(const std::uint8_t* data, std::size_t size, std::size_t& offset);
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef GENETIC_MULTIPLEXER_GEOMETRY_H
+#define GENETIC_MULTIPLEXER_GEOMETRY_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include "bitslice.h"
+#include "constants.h"
+
+/*
+ * The largest address pin count whose evaluation is compiled for its own block width. Six address
+ * pins have seventy options, which is more rows than a std::size_t can count, so only the
+ * decision diagram evaluator scores them and there are no row blocks to specialize.
+ */
+constexpr int largestSpecializedPins{5};
+
+/*
+ * The shape of the truth table of a multiplexer with a fixed address pin count, matching what
+ * the truth table works out at runtime. Every block holds the same number of words, since the
+ * row count is a power of two which is either below a full block or a multiple of one.
+ */
+template<int AddressPins>
+struct PinGeometry
+{
+    static_assert(1 <= AddressPins && AddressPins <= largestSpecializedPins);
+    static constexpr int addressPins = AddressPins;
+    static constexpr std::size_t optionsCount = AddressPins + (std::size_t{1} << AddressPins);
+    static constexpr std::size_t combinations = std::size_t{1} << optionsCount;
+    static constexpr std::size_t totalWords = (combinations + rowsPerWord - 1) / rowsPerWord;
+    static constexpr std::size_t blockWords = std::min(totalWords, bitSlicedBlockWords);
+    static constexpr std::size_t blockCount = totalWords / blockWords;
+    static constexpr std::size_t blockRows = std::min(combinations, blockWords * rowsPerWord);
+    static constexpr std::size_t sliceWords = std::min(blockWords, boundCheckWords);
+    static constexpr std::uint64_t validMask = combinations < rowsPerWord
+                                               ? (1ULL << combinations) - 1 : ~0ULL;
+    static_assert(totalWords % blockWords == 0 && blockWords % sliceWords == 0);
+};
+
+/*
+ * Calls the function with the geometry of the address pin count if it is specialized. Returns
+ * whether it was, so that the caller can fall back to the block widths of the truth table.
+ */
+template<typename Function>
+bool withPinGeometry(std::size_t addressPins, Function function) {
+    switch (addressPins) {
+        case 1:
+            function(PinGeometry<1>{});
+            return true;
+        case 2:
+            function(PinGeometry<2>{});
+            return true;
+        case 3:
+            function(PinGeometry<3>{});
+            return true;
+        case 4:
+            function(PinGeometry<4>{});
+            return true;
+        case 5:
+            function(PinGeometry<5>{});
+            return true;
+        default:
+            return false;
+    }
+}
+
+/*
+ * The bitwise operations over a fixed number of words. Narrow blocks are inlined into the
+ * evaluation loops, where the constant bound lets the compiler unroll and vectorize them.
+ */
+template<std::size_t Words>
+inline void fixedCopy(const std::uint64_t* in, std::uint64_t* out) {
+    std::copy(in, in + Words, out);
+}
+
+template<std::size_t Words>
+inline void fixedNot(std::uint64_t* out) {
+    if constexpr (Words > inlinedBlockWords) {
+        bitNot(out, Words);
+    } else {
+        for (std::size_t i = 0; i < Words; i++) {
+            out[i] = ~out[i];
+        }
+    }
+}
+
+template<std::size_t Words>
+inline void fixedAnd(std::uint64_t* out, const std::uint64_t* other) {
+    if constexpr (Words > inlinedBlockWords) {
+        bitAnd(out, other, Words);
+    } else {
+        for (std::size_t i = 0; i < Words; i++) {
+            out[i] &= other[i];
+        }
+    }
+}
+
+template<std::size_t Words>
+inline void fixedOr(std::uint64_t* out, const std::uint64_t* other) {
+    if constexpr (Words > inlinedBlockWords) {
+        bitOr(out, other, Words);
+    } else {
+        for (std::size_t i = 0; i < Words; i++) {
+            out[i] |= other[i];
+        }
+    }
+}
+
+template<std::size_t Words>
+inline void fixedSelect(std::uint64_t* out, const std::uint64_t* trueCase,
+                        const std::uint64_t* falseCase) {
+    if constexpr (Words > inlinedBlockWords) {
+        bitSelect(out, trueCase, falseCase, Words);
+    } else {
+        for (std::size_t i = 0; i < Words; i++) {
+            out[i] = (out[i] & trueCase[i]) | (~out[i] & falseCase[i]);
+        }
+    }
+}
+
+/*
+ * Same as countAgreement, for a block or slice of the geometry. Only a truth table of a single
+ * word has rows past its end, so every slice has the valid mask of the geometry.
+ */
+template<typename Geometry, std::size_t Words>
+inline std::uint64_t fixedAgreement(const std::uint64_t* predicted, const RowBlock& block) {
+    assert(block.words == Words && block.validMask == Geometry::validMask);
+    constexpr std::size_t last = Words - 1;
+    std::uint64_t agree = 0;
+    if constexpr (last > 0) {
+        agree = countAgreement(predicted, block.target, last);
+    }
+    agree += __builtin_popcountll(~(predicted[last] ^ block.target[last]) & Geometry::validMask);
+    return agree;
+}
+
+#endif
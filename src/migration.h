@@ -0,0 +1,89 @@
+#ifndef GENETIC_MULTIPLEXER_MIGRATION_H
+#define GENETIC_MULTIPLEXER_MIGRATION_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+/*
+ * A bounded lock-free queue which any number of islands may push migrants into and pop them
+ * from. Every cell carries a sequence number which tells whether it is ready to be written or
+ * read in the current lap around the ring, so producers and consumers only ever contend on the
+ * position counters. A push into a full queue fails rather than waiting, dropping the migrant.
+ */
+template<typename T>
+class MigrationQueue
+{
+private:
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+    std::unique_ptr<Cell[]> cells;
+    std::size_t mask;
+    alignas(64) std::atomic<std::size_t> pushPosition{0};
+    alignas(64) std::atomic<std::size_t> popPosition{0};
+public:
+    /* The capacity is rounded up to a power of two. */
+    explicit MigrationQueue(std::size_t capacity) {
+        std::size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1U;
+        }
+        cells = std::make_unique<Cell[]>(rounded);
+        mask = rounded - 1;
+        for (std::size_t i = 0; i < rounded; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MigrationQueue(const MigrationQueue&) = delete;
+    MigrationQueue& operator=(const MigrationQueue&) = delete;
+
+    [[nodiscard]] bool tryPush(T& value) {
+        std::size_t position = pushPosition.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells[position & mask];
+            std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            auto lap = static_cast<std::ptrdiff_t>(sequence - position);
+            if (lap == 0) {
+                if (pushPosition.compare_exchange_weak(position, position + 1,
+                                                       std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (lap < 0) {
+                return false;
+            } else {
+                position = pushPosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    [[nodiscard]] bool tryPop(T& value) {
+        std::size_t position = popPosition.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells[position & mask];
+            std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            auto lap = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+            if (lap == 0) {
+                if (popPosition.compare_exchange_weak(position, position + 1,
+                                                      std::memory_order_relaxed)) {
+                    value = std::move(cell.value);
+                    cell.value = T{};
+                    cell.sequence.store(position + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (lap < 0) {
+                return false;
+            } else {
+                position = popPosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,331 @@
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include "bitslice.h"
+#include "options.h"
+#include "semantics.h"
+
+bool parseEvaluator(const std::string& name, Evaluator& evaluator) {
+    if (name == "scalar") {
+        evaluator = Evaluator::scalar;
+        return true;
+    }
+    if (name == "bitsliced") {
+        evaluator = Evaluator::bitSliced;
+        return true;
+    }
+    if (name == "bytecode") {
+        evaluator = Evaluator::bytecode;
+        return true;
+    }
+    if (name == "bdd") {
+        evaluator = Evaluator::decisionDiagram;
+        return true;
+    }
+    if (name == "incremental") {
+        evaluator = Evaluator::incremental;
+        return true;
+    }
+    std::cerr << "Error: unknown evaluator (" << name << ")" << std::endl;
+    return false;
+}
+
+bool parseLayout(const std::string& name, GenomeLayout& layout) {
+    if (name == "tree") {
+        layout = GenomeLayout::tree;
+        return true;
+    }
+    if (name == "linear") {
+        layout = GenomeLayout::linear;
+        return true;
+    }
+    if (name == "shared") {
+        layout = GenomeLayout::shared;
+        return true;
+    }
+    std::cerr << "Error: unknown genome layout (" << name << ")" << std::endl;
+    return false;
+}
+
+bool parseAllocator(const std::string& name, NodeAllocator& allocator) {
+    if (name == "heap") {
+        allocator = NodeAllocator::heap;
+        return true;
+    }
+    if (name == "arena") {
+        allocator = NodeAllocator::arena;
+        return true;
+    }
+    if (name == "hugepages") {
+        allocator = NodeAllocator::hugePages;
+        return true;
+    }
+    std::cerr << "Error: unknown node allocator (" << name << ")" << std::endl;
+    return false;
+}
+
+bool parseTopology(const std::string& name, MigrationTopology& topology) {
+    if (name == "ring") {
+        topology = MigrationTopology::ring;
+        return true;
+    }
+    if (name == "random") {
+        topology = MigrationTopology::random;
+        return true;
+    }
+    std::cerr << "Error: unknown migration topology (" << name << ")" << std::endl;
+    return false;
+}
+
+/* Parses a count which must be at least one. */
+bool parsePositive(const std::string& value, const std::string& what, int& count) {
+    try {
+        count = std::stoi(value);
+    } catch (const std::logic_error& e) {
+        std::cerr << "Error: not representable (" << value << ")" << std::endl;
+        return false;
+    }
+    if (count < 1) {
+        std::cerr << "Error: " << what << " must be positive (" << value << ")" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    std::unordered_set<int> alreadyComputed{};
+    for (int i = 1; i < argc; i++) {
+        std::string argument{argv[i]};
+        if (argument.rfind("--", 0) == 0) {
+            if (i + 1 == argc) {
+                std::cerr << "Error: missing value for option (" << argument << ")" << std::endl;
+                return false;
+            }
+            std::string value{argv[++i]};
+            if (argument == "--evaluator") {
+                if (!parseEvaluator(value, options.evaluator)) {
+                    return false;
+                }
+                continue;
+            }
+            if (argument == "--genome") {
+                if (!parseLayout(value, options.layout)) {
+                    return false;
+                }
+                continue;
+            }
+            if (argument == "--allocator") {
+                if (!parseAllocator(value, options.allocator)) {
+                    return false;
+                }
+                continue;
+            }
+            if (argument == "--threads") {
+                if (!parsePositive(value, "thread count", options.threads)) {
+                    return false;
+                }
+                continue;
+            }
+            if (argument == "--islands") {
+                if (!parsePositive(value, "island count", options.islands)) {
+                    return false;
+                }
+                continue;
+            }
+            if (argument == "--migration-interval") {
+                if (!parsePositive(value, "migration interval", options.migrationInterval)) {
+                    return false;
+                }
+                continue;
+            }
+            if (argument == "--migrants") {
+                if (!parsePositive(value, "migrant count", options.migrants)) {
+                    return false;
+                }
+                if (options.migrants > populationSize / selectionPerTournament) {
+                    std::cerr << "Error: more migrants than tournaments (" << value << ")"
+                              << std::endl;
+                    return false;
+                }
+                continue;
+            }
+            if (argument == "--topology") {
+                if (!parseTopology(value, options.topology)) {
+                    return false;
+                }
+                continue;
+            }
+            if (argument == "--sample-rows") {
+                if (!parsePositive(value, "sampled row count", options.sampleRows)) {
+                    return false;
+                }
+                continue;
+            }
+            if (argument == "--workers") {
+                if (!parsePositive(value, "worker count", options.farmWorkers)) {
+                    return false;
+                }
+                continue;
+            }
+            if (argument == "--worker") {
+                options.workerAddresses.emplace_back(value);
+                continue;
+            }
+            if (argument == "--serve") {
+                options.serveAddress = value;
+                continue;
+            }
+            if (argument == "--checkpoint-interval") {
+                if (!parsePositive(value, "checkpoint interval", options.checkpointInterval)) {
+                    return false;
+                }
+                continue;
+            }
+            if (argument == "--resume") {
+                if (value != "on" && value != "off") {
+                    std::cerr << "Error: resume must be on or off (" << value << ")" << std::endl;
+                    return false;
+                }
+                options.resume = value == "on";
+                continue;
+            }
+            if (argument == "--seed") {
+                std::size_t parsed = 0;
+                try {
+                    options.seed = std::stoull(value, &parsed);
+                } catch (const std::logic_error& e) {
+                    parsed = 0;
+                }
+                if (parsed == 0 || parsed != value.size() || value.front() == '-') {
+                    std::cerr << "Error: not representable (" << value << ")" << std::endl;
+                    return false;
+                }
+                continue;
+            }
+            if (argument == "--telemetry") {
+                options.telemetryPath = value;
+                continue;
+            }
+            if (argument == "--cache") {
+                if (value != "on" && value != "off") {
+                    std::cerr << "Error: cache must be on or off (" << value << ")" << std::endl;
+                    return false;
+                }
+                options.cache = value == "on";
+                continue;
+            }
+            if (argument == "--bounds") {
+                if (value != "on" && value != "off") {
+                    std::cerr << "Error: bounds must be on or off (" << value << ")" << std::endl;
+                    return false;
+                }
+                options.bounds = value == "on";
+                continue;
+            }
+            if (argument == "--batch") {
+                if (value != "on" && value != "off") {
+                    std::cerr << "Error: batch must be on or off (" << value << ")" << std::endl;
+                    return false;
+                }
+                options.batch = value == "on";
+                continue;
+            }
+            if (argument == "--semantics-memory") {
+                long long megabytes;
+                try {
+                    megabytes = std::stoll(value);
+                } catch (const std::logic_error& e) {
+                    std::cerr << "Error: not representable (" << value << ")" << std::endl;
+                    return false;
+                }
+                if (megabytes < 1) {
+                    std::cerr << "Error: semantics memory must be positive (" << value << ")"
+                              << std::endl;
+                    return false;
+                }
+                options.semanticsMegabytes = static_cast<std::size_t>(megabytes);
+                continue;
+            }
+            if (argument == "--kernels") {
+                if (!selectBitKernels(value)) {
+                    std::cerr << "Error: unsupported kernels (" << value << ")" << std::endl;
+                    return false;
+                }
+                continue;
+            }
+            std::cerr << "Error: unknown option (" << argument << ")" << std::endl;
+            return false;
+        }
+        int pins;
+        try {
+            pins = std::stoi(argument);
+        } catch (const std::logic_error& e) {
+            std::cerr << "Error: not representable (" << argument << ")" << std::endl;
+            return false;
+        }
+        if (pins < 1) {
+            std::cerr << "Error: address pin count must be positive (" << pins << ")" << std::endl;
+            return false;
+        }
+        if (alreadyComputed.count(pins)) {
+            std::cerr << "Warn: ignoring duplicate (" << pins << ")" << std::endl;
+            continue;
+        }
+        alreadyComputed.insert(pins);
+        options.addressPins.emplace_back(pins);
+    }
+    if (options.evaluator == Evaluator::incremental && options.layout != GenomeLayout::shared) {
+        std::cerr << "Error: the incremental evaluator requires the shared genome" << std::endl;
+        return false;
+    }
+    if (options.evaluator == Evaluator::incremental) {
+        std::size_t budgetBytes = options.semanticsMegabytes << 20U;
+        for (int pins : options.addressPins) {
+            std::size_t optionsCount = pins + (static_cast<std::size_t>(1) << std::min(pins, 63));
+            if (TruthTable::columnWords(optionsCount) == 0) {
+                continue;
+            }
+            if (!SemanticsCache::fitsBudget(optionsCount, budgetBytes)) {
+                std::cerr << "Error: the semantics memory cannot hold the truth table and one "
+                          << "subtree output of " << pins << " address pins; pass a larger "
+                          << "--semantics-memory" << std::endl;
+                return false;
+            }
+        }
+    }
+    bool farming = options.farmWorkers > 0 || !options.workerAddresses.empty();
+    if (farming && options.evaluator == Evaluator::incremental) {
+        std::cerr << "Error: the incremental evaluator cannot be farmed out" << std::endl;
+        return false;
+    }
+    if (farming && options.sampleRows > 0) {
+        std::cerr << "Error: sampled fitness cannot be farmed out" << std::endl;
+        return false;
+    }
+    bool blockEvaluator = options.evaluator == Evaluator::bitSliced
+                          || options.evaluator == Evaluator::bytecode;
+    if (options.batch && !blockEvaluator) {
+        std::cerr << "Error: batches require the bitsliced or bytecode evaluator" << std::endl;
+        return false;
+    }
+    if (options.batch && farming) {
+        std::cerr << "Error: the farm already scores the whole population" << std::endl;
+        return false;
+    }
+    if (options.batch && options.sampleRows > 0) {
+        std::cerr << "Error: sampled fitness cannot be batched" << std::endl;
+        return false;
+    }
+    bool checkpointing = options.checkpointInterval > 0 || options.resume;
+    if (checkpointing && options.islands > 1) {
+        std::cerr << "Error: island populations cannot be checkpointed" << std::endl;
+        return false;
+    }
+    if (options.islands > 1 && options.threads > 1) {
+        std::cerr << "Error: islands already run on their own threads" << std::endl;
+        return false;
+    }
+    return true;
+}
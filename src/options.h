@@ -0,0 +1,58 @@
+#ifndef GENETIC_MULTIPLEXER_OPTIONS_H
+#define GENETIC_MULTIPLEXER_OPTIONS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "arena.h"
+#include "constants.h"
+#include "fitness.h"
+
+enum class GenomeLayout
+{
+    tree,
+    linear,
+    shared,
+};
+
+/* Whether migrants go to the next island in a ring, or to another island at random. */
+enum class MigrationTopology
+{
+    ring,
+    random,
+};
+
+struct Options
+{
+    std::vector<int> addressPins{};
+    Evaluator evaluator{Evaluator::bitSliced};
+    GenomeLayout layout{GenomeLayout::tree};
+    NodeAllocator allocator{NodeAllocator::arena};
+    int threads{1};
+    bool cache{true};
+    bool bounds{true};
+    bool batch{false};
+    std::size_t semanticsMegabytes{semanticsCacheMegabytes};
+    int islands{1};
+    int migrationInterval{islandMigrationInterval};
+    int migrants{islandMigrantCount};
+    MigrationTopology topology{MigrationTopology::ring};
+    int sampleRows{0};
+    int farmWorkers{0};
+    std::vector<std::string> workerAddresses{};
+    std::string serveAddress{};
+    std::string telemetryPath{};
+    int checkpointInterval{0};
+    bool resume{false};
+    std::optional<std::uint64_t> seed{};
+};
+
+/*
+ * Parses the address pin counts along with any flags. Returns false and reports the reason to
+ * the error stream if the arguments are malformed.
+ */
+bool parseOptions(int argc, char* argv[], Options& options);
+
+#endif
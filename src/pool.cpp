@@ -0,0 +1,99 @@
+#include <cassert>
+#include "pool.h"
+
+WorkStealingPool::WorkStealingPool(int workers) {
+    assert(workers >= 1);
+    for (int i = 0; i < workers; i++) {
+        queues.emplace_back(std::make_unique<Queue>());
+    }
+    for (int i = 1; i < workers; i++) {
+        threads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock{batchMutex};
+        stopping = true;
+    }
+    batchStarted.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+int WorkStealingPool::workerCount() const {
+    return static_cast<int>(queues.size());
+}
+
+bool WorkStealingPool::takeTask(int worker, int& task) {
+    {
+        Queue& own = *queues[worker];
+        std::lock_guard<std::mutex> lock{own.mutex};
+        if (!own.tasks.empty()) {
+            task = own.tasks.front();
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+    for (std::size_t offset = 1; offset < queues.size(); offset++) {
+        Queue& victim = *queues[(worker + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock{victim.mutex};
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::work(int worker) {
+    int task;
+    while (takeTask(worker, task)) {
+        (*body)(task, worker);
+    }
+}
+
+void WorkStealingPool::workerLoop(int worker) {
+    int seenBatch = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock{batchMutex};
+            batchStarted.wait(lock, [&] { return stopping || batch != seenBatch; });
+            if (stopping) {
+                return;
+            }
+            seenBatch = batch;
+        }
+        work(worker);
+        {
+            std::lock_guard<std::mutex> lock{batchMutex};
+            busyWorkers--;
+        }
+        batchFinished.notify_one();
+    }
+}
+
+void WorkStealingPool::run(int tasks, const std::function<void(int, int)>& body) {
+    int workers = workerCount();
+    for (int i = 0; i < workers; i++) {
+        int begin = static_cast<int>(static_cast<long long>(tasks) * i / workers);
+        int end = static_cast<int>(static_cast<long long>(tasks) * (i + 1) / workers);
+        std::lock_guard<std::mutex> lock{queues[i]->mutex};
+        for (int task = begin; task < end; task++) {
+            queues[i]->tasks.push_back(task);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock{batchMutex};
+        this->body = &body;
+        busyWorkers = workers - 1;
+        batch++;
+    }
+    batchStarted.notify_all();
+    work(0);
+    std::unique_lock<std::mutex> lock{batchMutex};
+    batchFinished.wait(lock, [&] { return busyWorkers == 0; });
+    this->body = nullptr;
+}
@@ -0,0 +1,47 @@
+#ifndef GENETIC_MULTIPLEXER_POOL_H
+#define GENETIC_MULTIPLEXER_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * A fixed set of worker threads which run batches of indexed tasks. Each worker starts a batch
+ * with its own contiguous share of the task indices, and once it runs out, steals tasks from
+ * the back of the other workers' queues. The calling thread takes part as worker zero.
+ */
+class WorkStealingPool
+{
+private:
+    struct Queue
+    {
+        std::mutex mutex{};
+        std::deque<int> tasks{};
+    };
+    std::vector<std::unique_ptr<Queue>> queues{};
+    std::vector<std::thread> threads{};
+    std::mutex batchMutex{};
+    std::condition_variable batchStarted{};
+    std::condition_variable batchFinished{};
+    const std::function<void(int, int)>* body{nullptr};
+    int batch{0};
+    int busyWorkers{0};
+    bool stopping{false};
+    bool takeTask(int worker, int& task);
+    void work(int worker);
+    void workerLoop(int worker);
+public:
+    explicit WorkStealingPool(int workers);
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+    ~WorkStealingPool();
+    [[nodiscard]] int workerCount() const;
+    /* Calls body(task, worker) for every task in [0, tasks) and waits for all of them. */
+    void run(int tasks, const std::function<void(int, int)>& body);
+};
+
+#endif
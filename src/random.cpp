@@ -0,0 +1,151 @@
+#include <cassert>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include "random.h"
+
+std::uint64_t splitMix(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27U)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31U);
+}
+
+std::uint64_t rotateLeft(std::uint64_t value, unsigned shift) {
+    return (value << shift) | (value >> (64U - shift));
+}
+
+RandomGenerator::RandomGenerator(std::uint64_t seed) {
+    this->seed(seed);
+}
+
+void RandomGenerator::seed(std::uint64_t seed) {
+    for (std::uint64_t& word : words) {
+        word = splitMix(seed);
+    }
+}
+
+std::uint64_t RandomGenerator::next() {
+    std::uint64_t result = rotateLeft(words[1] * 5, 7) * 9;
+    std::uint64_t shifted = words[1] << 17U;
+    words[2] ^= words[0];
+    words[3] ^= words[1];
+    words[1] ^= words[2];
+    words[0] ^= words[3];
+    words[2] ^= shifted;
+    words[3] = rotateLeft(words[3], 45);
+    return result;
+}
+
+void RandomGenerator::fill(std::uint64_t* out, std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) {
+        out[i] = next();
+    }
+}
+
+const std::array<std::uint64_t, 4>& RandomGenerator::state() const {
+    return words;
+}
+
+void RandomGenerator::restore(const std::array<std::uint64_t, 4>& state) {
+    words = state;
+}
+
+RandomStream::RandomStream(std::uint64_t seed) : generator{seed} {}
+
+void RandomStream::seed(std::uint64_t seed) {
+    generator.seed(seed);
+    position = randomBufferWords;
+}
+
+void RandomStream::refill() {
+    refillState = generator.state();
+    generator.fill(buffer.data(), buffer.size());
+    position = 0;
+}
+
+std::uint64_t RandomStream::next() {
+    if (position == randomBufferWords) {
+        refill();
+    }
+    return buffer[position++];
+}
+
+std::uint64_t RandomStream::below(std::uint64_t bound) {
+    assert(bound > 0);
+    unsigned __int128 product = static_cast<unsigned __int128>(next()) * bound;
+    auto low = static_cast<std::uint64_t>(product);
+    if (low < bound) {
+        std::uint64_t threshold = -bound % bound;
+        while (low < threshold) {
+            product = static_cast<unsigned __int128>(next()) * bound;
+            low = static_cast<std::uint64_t>(product);
+        }
+    }
+    return static_cast<std::uint64_t>(product >> 64U);
+}
+
+double RandomStream::real() {
+    return static_cast<double>(next() >> 11U) * 0x1.0p-53;
+}
+
+std::string RandomStream::state() const {
+    bool drained = position == randomBufferWords;
+    std::ostringstream state{};
+    for (std::uint64_t word : drained ? generator.state() : refillState) {
+        state << word << ' ';
+    }
+    state << position;
+    return state.str();
+}
+
+void RandomStream::restore(const std::string& state) {
+    std::istringstream stream{state};
+    std::array<std::uint64_t, 4> words{};
+    std::size_t restoredPosition = 0;
+    for (std::uint64_t& word : words) {
+        stream >> word;
+    }
+    stream >> restoredPosition;
+    if (stream.fail() || !(stream >> std::ws).eof() || restoredPosition > randomBufferWords) {
+        throw std::runtime_error{"Invalid generator state"};
+    }
+    generator.restore(words);
+    position = randomBufferWords;
+    if (restoredPosition < randomBufferWords) {
+        refill();
+        position = restoredPosition;
+    }
+}
+
+RandomStream& threadRandom() {
+    thread_local RandomStream stream{(static_cast<std::uint64_t>(std::random_device{}()) << 32U)
+                                     | std::random_device{}()};
+    return stream;
+}
+
+void seedGenerator(std::uint64_t streamSeed) {
+    threadRandom().seed(streamSeed);
+}
+
+std::uint64_t randomSeed() {
+    return threadRandom().next();
+}
+
+std::string generatorState() {
+    return threadRandom().state();
+}
+
+void restoreGenerator(const std::string& state) {
+    threadRandom().restore(state);
+}
+
+int uniformIntegerInclusiveBounds(int low, int high) {
+    assert(low <= high);
+    auto range = static_cast<std::uint64_t>(static_cast<std::int64_t>(high) - low) + 1;
+    return static_cast<int>(low + static_cast<std::int64_t>(threadRandom().below(range)));
+}
+
+double uniformReal() {
+    return threadRandom().real();
+}
@@ -0,0 +1,79 @@
+#ifndef GENETIC_MULTIPLEXER_RANDOM_H
+#define GENETIC_MULTIPLEXER_RANDOM_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "constants.h"
+
+/*
+ * The xoshiro256** generator. It is seeded through SplitMix64, so that every seed, even zero,
+ * starts from a well mixed state, and its whole state is four words.
+ */
+class RandomGenerator
+{
+private:
+    std::array<std::uint64_t, 4> words{};
+public:
+    explicit RandomGenerator(std::uint64_t seed);
+    void seed(std::uint64_t seed);
+    [[nodiscard]] std::uint64_t next();
+    /* Writes the next outputs to the words, in the order next would return them. */
+    void fill(std::uint64_t* out, std::size_t count);
+    [[nodiscard]] const std::array<std::uint64_t, 4>& state() const;
+    void restore(const std::array<std::uint64_t, 4>& state);
+};
+
+/*
+ * Hands out the outputs of a generator from a buffer which is refilled a block at a time, and
+ * turns them into bounded integers and reals. Bounded integers use Lemire's multiply and reject,
+ * which needs no division unless the output falls in the biased range.
+ */
+class RandomStream
+{
+private:
+    RandomGenerator generator;
+    std::array<std::uint64_t, 4> refillState{};
+    std::array<std::uint64_t, randomBufferWords> buffer{};
+    std::size_t position{randomBufferWords};
+    void refill();
+public:
+    explicit RandomStream(std::uint64_t seed);
+    /* Starts over from the seed, dropping whatever is left in the buffer. */
+    void seed(std::uint64_t seed);
+    [[nodiscard]] std::uint64_t next();
+    /* Uniform in [0, bound), where the bound must be positive. */
+    [[nodiscard]] std::uint64_t below(std::uint64_t bound);
+    /* Uniform in [0, 1), with every multiple of 2^-53 equally likely. */
+    [[nodiscard]] double real();
+    /* The state of the generator when the buffer was last refilled and the position in it. */
+    [[nodiscard]] std::string state() const;
+    /* Throws if the state is malformed. */
+    void restore(const std::string& state);
+};
+
+/*
+ * The stream of the calling thread, which starts from a seed drawn from the random device. The
+ * free functions below all draw from it.
+ */
+RandomStream& threadRandom();
+
+/*
+ * Seeding a thread's generator starts a stream which does not depend on what the thread ran
+ * before.
+ */
+void seedGenerator(std::uint64_t streamSeed);
+
+std::uint64_t randomSeed();
+
+/* The state of the calling thread's generator, which restoring continues the same stream. */
+std::string generatorState();
+
+void restoreGenerator(const std::string& state);
+
+int uniformIntegerInclusiveBounds(int low, int high);
+
+double uniformReal();
+
+#endif
@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include "constants.h"
+#include "random.h"
+#include "sampling.h"
+
+std::size_t roundUpToWords(std::size_t rows) {
+    return (rows + rowsPerWord - 1) / rowsPerWord * rowsPerWord;
+}
+
+RowSample::RowSample(std::size_t addressPins, std::size_t optionsCount, std::size_t minimumRows)
+        : addressPins{addressPins}, optionsCount{optionsCount},
+          minimumRows{roundUpToWords(std::max<std::size_t>(minimumRows, 1))} {
+    resample();
+}
+
+/*
+ * A fraction estimated from n rows has a standard error of sqrt(p (1 - p) / n), so n is chosen
+ * to bring that error down to a fixed share of the standard deviation between trees.
+ */
+std::size_t RowSample::adaptedRows() const {
+    if (recorded < 2) {
+        return std::max(rows, minimumRows);
+    }
+    double mean = sum / recorded;
+    double variance = std::max(0.0, sumOfSquares / recorded - mean * mean);
+    double wanted = sampledRowsMaximum;
+    if (variance > 0) {
+        double error = sampleErrorShare * std::sqrt(variance);
+        wanted = std::min(wanted, mean * (1 - mean) / (error * error));
+    }
+    auto adapted = static_cast<std::size_t>(std::ceil(wanted));
+    return roundUpToWords(std::clamp(adapted, minimumRows, sampledRowsMaximum));
+}
+
+void RowSample::resample() {
+    std::lock_guard<std::mutex> lock{mutex};
+    rows = adaptedRows();
+    recorded = 0;
+    sum = 0;
+    sumOfSquares = 0;
+    std::size_t words = rows / rowsPerWord;
+    RandomGenerator bits{randomSeed()};
+    columns.resize(optionsCount * words);
+    bits.fill(columns.data(), columns.size());
+    target.assign(words, 0);
+    std::size_t dataPins = optionsCount - addressPins;
+    for (std::size_t i = 0; i < blockCount(); i++) {
+        RowBlock sampled = block(i);
+        std::uint64_t* blockTarget = target.data() + i * bitSlicedBlockWords;
+        for (std::size_t address = 0; address < dataPins; address++) {
+            const std::uint64_t* data = sampled.column(addressPins + address);
+            for (std::size_t w = 0; w < sampled.words; w++) {
+                std::uint64_t match = data[w];
+                for (std::size_t j = 0; j < addressPins; j++) {
+                    std::uint64_t pin = sampled.column(j)[w];
+                    bool set = (address >> ((addressPins - 1) - j)) & 1U;
+                    match &= set ? pin : ~pin;
+                }
+                blockTarget[w] |= match;
+            }
+        }
+    }
+}
+
+std::size_t RowSample::rowCount() const {
+    return rows;
+}
+
+std::size_t RowSample::blockCount() const {
+    std::size_t words = rows / rowsPerWord;
+    return (words + bitSlicedBlockWords - 1) / bitSlicedBlockWords;
+}
+
+/* The columns are stored block after block, each block pin-major like a generated one. */
+RowBlock RowSample::block(std::size_t blockIndex) const {
+    assert(blockIndex < blockCount());
+    std::size_t words = rows / rowsPerWord;
+    std::size_t firstWord = blockIndex * bitSlicedBlockWords;
+    std::size_t blockWords = std::min(bitSlicedBlockWords, words - firstWord);
+    return RowBlock{blockWords, ~0ULL, columns.data() + optionsCount * firstWord,
+                    target.data() + firstWord, blockWords};
+}
+
+void RowSample::record(double fraction) {
+    std::lock_guard<std::mutex> lock{mutex};
+    recorded++;
+    sum += fraction;
+    sumOfSquares += fraction * fraction;
+}
@@ -0,0 +1,43 @@
+#ifndef GENETIC_MULTIPLEXER_SAMPLING_H
+#define GENETIC_MULTIPLEXER_SAMPLING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "bitslice.h"
+
+/*
+ * A random subset of truth table rows, drawn with replacement and packed 64 rows per word into
+ * blocks just like the whole truth table. Every pin of a sampled row is an independent random
+ * bit, so rows are drawn without ever numbering them, however many pins there are. The sample
+ * also collects the fraction of correct rows of every tree scored on it, and the next sample
+ * grows as those fractions draw closer together, so that sampling noise stays small next to the
+ * differences between trees.
+ */
+class RowSample
+{
+private:
+    std::size_t addressPins;
+    std::size_t optionsCount;
+    std::size_t minimumRows;
+    std::size_t rows{0};
+    std::vector<std::uint64_t> columns{};
+    std::vector<std::uint64_t> target{};
+    std::mutex mutex{};
+    std::size_t recorded{0};
+    double sum{0};
+    double sumOfSquares{0};
+    [[nodiscard]] std::size_t adaptedRows() const;
+public:
+    /* The minimum row count is rounded up to a whole number of words. */
+    RowSample(std::size_t addressPins, std::size_t optionsCount, std::size_t minimumRows);
+    /* Draws new rows, sized by the spread of the fractions recorded since the last draw. */
+    void resample();
+    [[nodiscard]] std::size_t rowCount() const;
+    [[nodiscard]] std::size_t blockCount() const;
+    [[nodiscard]] RowBlock block(std::size_t blockIndex) const;
+    void record(double fraction);
+};
+
+#endif
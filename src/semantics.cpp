@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include "constants.h"
+#include "fitness.h"
+#include "semantics.h"
+
+/* Every cached output also pays for its list node, map node, and shared state. */
+constexpr std::size_t entryOverheadBytes{128};
+
+std::size_t outputBytes(std::size_t optionsCount) {
+    return TruthTable::columnWords(optionsCount) * sizeof(std::uint64_t) + entryOverheadBytes;
+}
+
+/* The pin columns and target of the truth table, or of one generated block if not precomputed. */
+std::size_t tableBytes(std::size_t optionsCount) {
+    std::size_t words = bitSlicedBlockWords;
+    if (TruthTable::precomputes(optionsCount)) {
+        words = TruthTable::columnWords(optionsCount);
+    }
+    return (optionsCount + 1) * words * sizeof(std::uint64_t);
+}
+
+bool SemanticsCache::fitsBudget(std::size_t optionsCount, std::size_t budgetBytes) {
+    return TruthTable::columnWords(optionsCount) > 0
+           && tableBytes(optionsCount) + outputBytes(optionsCount) <= budgetBytes;
+}
+
+SemanticsCache::SemanticsCache(const TruthTable& table, std::size_t budgetBytes)
+        : table{table}, words{TruthTable::columnWords(table.optionCount())},
+          budgetBytes{budgetBytes}, usedBytes{tableBytes(table.optionCount())} {
+    if (!fitsBudget(table.optionCount(), budgetBytes)) {
+        throw std::runtime_error{"A subtree output does not fit in the semantics memory"};
+    }
+    combinations = calculateCombinations(table.optionCount());
+}
+
+SemanticsCache::Output SemanticsCache::lookup(std::uint64_t hash) {
+    std::lock_guard<std::mutex> lock{mutex};
+    auto found = entries.find(hash);
+    if (found == entries.end()) {
+        misses++;
+        return nullptr;
+    }
+    hits++;
+    recency.splice(recency.begin(), recency, found->second);
+    return found->second->output;
+}
+
+/* The truth table and one output fit in the budget, so eviction always makes enough room. */
+void SemanticsCache::insert(std::uint64_t hash, const Output& output) {
+    std::size_t bytes = outputBytes(table.optionCount());
+    std::lock_guard<std::mutex> lock{mutex};
+    if (entries.count(hash)) {
+        return;
+    }
+    while (usedBytes + bytes > budgetBytes) {
+        entries.erase(recency.back().hash);
+        recency.pop_back();
+        usedBytes -= bytes;
+        evictions++;
+    }
+    recency.push_front(Entry{hash, output});
+    entries.emplace(hash, recency.begin());
+    usedBytes += bytes;
+}
+
+/* Terminal children have no output of their own, since their columns are in the truth table. */
+std::vector<SemanticsCache::Output> SemanticsCache::childOutputs(const SharedNode& node) {
+    std::vector<Output> outputs(arity(node.opcode()));
+    for (std::size_t i = 0; i < outputs.size(); i++) {
+        const SharedNode& child = *node.child(static_cast<int>(i));
+        if (child.opcode() != Opcode::Terminal) {
+            outputs[i] = outputOf(child);
+        }
+    }
+    return outputs;
+}
+
+/* Writes the output of the node over the block, which starts at the first word of the table. */
+void SemanticsCache::evaluateBlock(const SharedNode& node, const std::vector<Output>& children,
+                                   const RowBlock& block, std::size_t firstWord,
+                                   std::uint64_t* out) const {
+    auto operand = [&](int index) {
+        const SharedNode& child = *node.child(index);
+        if (child.opcode() == Opcode::Terminal) {
+            return block.column(child.terminalIndex());
+        }
+        return static_cast<const std::uint64_t*>(children[index]->data() + firstWord);
+    };
+    if (node.opcode() == Opcode::Terminal) {
+        const std::uint64_t* column = block.column(node.terminalIndex());
+        std::copy(column, column + block.words, out);
+        return;
+    }
+    const std::uint64_t* first = operand(0);
+    std::copy(first, first + block.words, out);
+    switch (node.opcode()) {
+        case Opcode::Not:
+            bitNot(out, block.words);
+            break;
+        case Opcode::And:
+            bitAnd(out, operand(1), block.words);
+            break;
+        case Opcode::Or:
+            bitOr(out, operand(1), block.words);
+            break;
+        case Opcode::If:
+            bitSelect(out, operand(1), operand(2), block.words);
+            break;
+        case Opcode::Terminal:
+            assert(false);
+    }
+}
+
+SemanticsCache::Output SemanticsCache::outputOf(const SharedNode& node) {
+    assert(node.opcode() != Opcode::Terminal);
+    Output cached = lookup(node.computeHash());
+    if (cached) {
+        return cached;
+    }
+    std::vector<Output> children = childOutputs(node);
+    auto output = std::make_shared<std::vector<std::uint64_t>>(words);
+    RowBlockGenerator generator{table};
+    for (std::size_t i = 0; i < generator.blockCount(); i++) {
+        std::size_t firstWord = i * bitSlicedBlockWords;
+        evaluateBlock(node, children, generator.generate(i), firstWord,
+                      output->data() + firstWord);
+    }
+    insert(node.computeHash(), output);
+    return output;
+}
+
+std::size_t SemanticsCache::correctLogicCount(const SharedNode& head) {
+    std::vector<Output> children = childOutputs(head);
+    std::vector<std::uint64_t> out(bitSlicedBlockWords);
+    RowBlockGenerator generator{table};
+    std::size_t correct = 0;
+    for (std::size_t i = 0; i < generator.blockCount(); i++) {
+        RowBlock block = generator.generate(i);
+        evaluateBlock(head, children, block, i * bitSlicedBlockWords, out.data());
+        correct += countAgreement(out.data(), block);
+    }
+    return correct;
+}
+
+double SemanticsCache::computeFitness(const SharedNode& head) {
+    int depth = head.computeDepth();
+    if (depth > maximumDepth) {
+        return 0;
+    }
+    return scaleFitness(correctLogicCount(head), combinations, depth);
+}
+
+std::uint64_t SemanticsCache::hitCount() {
+    std::lock_guard<std::mutex> lock{mutex};
+    return hits;
+}
+
+std::uint64_t SemanticsCache::missCount() {
+    std::lock_guard<std::mutex> lock{mutex};
+    return misses;
+}
+
+std::uint64_t SemanticsCache::evictionCount() {
+    std::lock_guard<std::mutex> lock{mutex};
+    return evictions;
+}
+
+void SemanticsCache::resetCounters() {
+    std::lock_guard<std::mutex> lock{mutex};
+    hits = 0;
+    misses = 0;
+    evictions = 0;
+}
@@ -0,0 +1,62 @@
+#ifndef GENETIC_MULTIPLEXER_SEMANTICS_H
+#define GENETIC_MULTIPLEXER_SEMANTICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "bitslice.h"
+#include "shared.h"
+
+/*
+ * Remembers the output of shared subtrees over every row of the truth table, keyed by their
+ * structural hash. Offspring share all unchanged subtrees with their parents, so evaluating
+ * them only computes the nodes on the path to the change, each from the cached outputs of its
+ * children and the pin columns of the truth table. The output of a root is counted block by block
+ * and never remembered, since the fitness cache already covers whole trees. The truth table is
+ * charged to the memory budget, and the least recently used outputs are evicted once it is
+ * exceeded. Throws if not even one output fits.
+ */
+class SemanticsCache
+{
+public:
+    using Output = std::shared_ptr<const std::vector<std::uint64_t>>;
+private:
+    struct Entry
+    {
+        std::uint64_t hash;
+        Output output;
+    };
+    const TruthTable& table;
+    std::size_t combinations;
+    std::size_t words;
+    std::size_t budgetBytes;
+    std::size_t usedBytes;
+    std::list<Entry> recency{};
+    std::unordered_map<std::uint64_t, std::list<Entry>::iterator> entries{};
+    std::mutex mutex{};
+    std::uint64_t hits{0};
+    std::uint64_t misses{0};
+    std::uint64_t evictions{0};
+    [[nodiscard]] Output lookup(std::uint64_t hash);
+    void insert(std::uint64_t hash, const Output& output);
+    [[nodiscard]] Output outputOf(const SharedNode& node);
+    [[nodiscard]] std::vector<Output> childOutputs(const SharedNode& node);
+    void evaluateBlock(const SharedNode& node, const std::vector<Output>& children,
+                       const RowBlock& block, std::size_t firstWord, std::uint64_t* out) const;
+public:
+    SemanticsCache(const TruthTable& table, std::size_t budgetBytes);
+    /* Whether the truth table of the options and a single output fit in the budget. */
+    [[nodiscard]] static bool fitsBudget(std::size_t optionsCount, std::size_t budgetBytes);
+    [[nodiscard]] std::size_t correctLogicCount(const SharedNode& head);
+    [[nodiscard]] double computeFitness(const SharedNode& head);
+    [[nodiscard]] std::uint64_t hitCount();
+    [[nodiscard]] std::uint64_t missCount();
+    [[nodiscard]] std::uint64_t evictionCount();
+    void resetCounters();
+};
+
+#endif
@@ -0,0 +1,347 @@
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include "arena.h"
+#include "constants.h"
+#include "expressions.h"
+#include "shared.h"
+
+void unreference(SharedNode* node);
+
+NodeRef::NodeRef(SharedNode* node) : node{node} {}
+
+NodeRef::NodeRef(const NodeRef& other) : node{other.node} {
+    if (node != nullptr) {
+        node->references.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+NodeRef::NodeRef(NodeRef&& other) noexcept : node{other.node} {
+    other.node = nullptr;
+}
+
+NodeRef& NodeRef::operator=(NodeRef other) noexcept {
+    std::swap(node, other.node);
+    return *this;
+}
+
+NodeRef::~NodeRef() {
+    if (node != nullptr) {
+        unreference(node);
+    }
+}
+
+const SharedNode* NodeRef::get() const {
+    return node;
+}
+
+const SharedNode* NodeRef::operator->() const {
+    return node;
+}
+
+const SharedNode& NodeRef::operator*() const {
+    return *node;
+}
+
+NodeRef::operator bool() const {
+    return node != nullptr;
+}
+
+/*
+ * The unique table is split into stripes by hash, each with its own lock. A node whose count
+ * dropped to zero may linger in the table until its releasing thread erases it, so lookups
+ * only ever take a reference to nodes which are still referenced.
+ */
+struct Stripe
+{
+    std::mutex mutex{};
+    std::unordered_multimap<std::uint64_t, SharedNode*> nodes{};
+};
+
+constexpr std::size_t stripeCount{64};
+
+Stripe& stripeOf(std::uint64_t hash) {
+    static Stripe stripes[stripeCount];
+    return stripes[hash % stripeCount];
+}
+
+std::atomic<std::size_t> liveNodes{0};
+
+std::uint64_t combineHash(std::uint64_t hash, std::uint64_t childHash) {
+    return hashGene(hash ^ childHash, Gene{Opcode::Terminal, 0});
+}
+
+SharedNode::SharedNode(Opcode op, std::uint16_t terminal, std::uint64_t hash, NodeRef first,
+                       NodeRef second, NodeRef third)
+        : op{op}, terminal{terminal}, depth{0}, logicSize{0}, hash{hash},
+          children{std::move(first), std::move(second), std::move(third)} {
+    for (int i = 0; i < arity(op); i++) {
+        depth = std::max(depth, children[i]->depth + 1);
+        logicSize += children[i]->logicSize;
+    }
+    logicSize += op == Opcode::Terminal ? 0 : 1;
+}
+
+void unreference(SharedNode* node) {
+    if (node->references.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    {
+        Stripe& stripe = stripeOf(node->hash);
+        std::lock_guard<std::mutex> lock{stripe.mutex};
+        auto range = stripe.nodes.equal_range(node->hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == node) {
+                stripe.nodes.erase(it);
+                break;
+            }
+        }
+    }
+    liveNodes.fetch_sub(1, std::memory_order_relaxed);
+    countNodeRelease();
+    delete node;
+}
+
+bool SharedNode::tryReference() {
+    int count = references.load(std::memory_order_relaxed);
+    while (count > 0) {
+        if (references.compare_exchange_weak(count, count + 1, std::memory_order_acq_rel)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+NodeRef internNode(Opcode op, std::uint16_t terminal, NodeRef first, NodeRef second,
+                   NodeRef third) {
+    assert(static_cast<bool>(first) == (arity(op) >= 1));
+    assert(static_cast<bool>(second) == (arity(op) >= 2));
+    assert(static_cast<bool>(third) == (arity(op) >= 3));
+    std::uint64_t hash = hashGene(0, Gene{op, terminal});
+    for (const NodeRef* child : {&first, &second, &third}) {
+        if (*child) {
+            hash = combineHash(hash, (*child)->hash);
+        }
+    }
+    Stripe& stripe = stripeOf(hash);
+    std::lock_guard<std::mutex> lock{stripe.mutex};
+    auto range = stripe.nodes.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        SharedNode* node = it->second;
+        bool same = node->op == op && node->terminal == terminal
+                    && node->children[0].get() == first.get()
+                    && node->children[1].get() == second.get()
+                    && node->children[2].get() == third.get();
+        if (same && node->tryReference()) {
+            return NodeRef{node};
+        }
+    }
+    auto* node = new SharedNode{op, terminal, hash, std::move(first), std::move(second),
+                                std::move(third)};
+    stripe.nodes.emplace(hash, node);
+    liveNodes.fetch_add(1, std::memory_order_relaxed);
+    countNodeAllocation();
+    return NodeRef{node};
+}
+
+NodeRef internGenes(const std::vector<Gene>& genes, std::size_t& index) {
+    Gene gene = genes[index++];
+    NodeRef children[3]{};
+    for (int i = 0; i < arity(gene.op); i++) {
+        children[i] = internGenes(genes, index);
+    }
+    return internNode(gene.op, gene.terminal, std::move(children[0]), std::move(children[1]),
+                      std::move(children[2]));
+}
+
+NodeRef internGenes(const std::vector<Gene>& genes) {
+    std::size_t index = 0;
+    NodeRef head = internGenes(genes, index);
+    assert(index == genes.size());
+    return head;
+}
+
+std::size_t sharedNodeCount() {
+    return liveNodes.load(std::memory_order_relaxed);
+}
+
+Opcode SharedNode::opcode() const {
+    return op;
+}
+
+std::uint16_t SharedNode::terminalIndex() const {
+    return terminal;
+}
+
+const NodeRef& SharedNode::child(int index) const {
+    assert(index < arity(op));
+    return children[index];
+}
+
+int SharedNode::computeDepth() const {
+    return depth;
+}
+
+int SharedNode::computeLogicSize() const {
+    return logicSize;
+}
+
+std::uint64_t SharedNode::computeHash() const {
+    return hash;
+}
+
+bool SharedNode::evaluate(const std::vector<char>& truthTable) const {
+    switch (op) {
+        case Opcode::Terminal:
+            return truthTable[terminal];
+        case Opcode::Not:
+            return !children[0]->evaluate(truthTable);
+        case Opcode::And:
+            return children[0]->evaluate(truthTable) && children[1]->evaluate(truthTable);
+        case Opcode::Or:
+            return children[0]->evaluate(truthTable) || children[1]->evaluate(truthTable);
+        case Opcode::If:
+            return children[0]->evaluate(truthTable) ? children[1]->evaluate(truthTable)
+                                                     : children[2]->evaluate(truthTable);
+    }
+    throw std::runtime_error{"Invalid opcode"};
+}
+
+void SharedNode::evaluate(const RowBlock& block, std::uint64_t* out,
+                          std::uint64_t* scratch) const {
+    std::size_t words = block.words;
+    switch (op) {
+        case Opcode::Terminal: {
+            const std::uint64_t* column = block.column(terminal);
+            std::copy(column, column + words, out);
+            return;
+        }
+        case Opcode::Not:
+            children[0]->evaluate(block, out, scratch);
+            bitNot(out, words);
+            return;
+        case Opcode::And:
+            children[0]->evaluate(block, out, scratch);
+            children[1]->evaluate(block, scratch, scratch + words);
+            bitAnd(out, scratch, words);
+            return;
+        case Opcode::Or:
+            children[0]->evaluate(block, out, scratch);
+            children[1]->evaluate(block, scratch, scratch + words);
+            bitOr(out, scratch, words);
+            return;
+        case Opcode::If:
+            children[0]->evaluate(block, out, scratch);
+            children[1]->evaluate(block, scratch, scratch + words);
+            children[2]->evaluate(block, scratch + words, scratch + 2 * words);
+            bitSelect(out, scratch, scratch + words, words);
+            return;
+    }
+}
+
+std::string SharedNode::prettyPrint(const std::vector<std::string>& options) const {
+    switch (op) {
+        case Opcode::Terminal:
+            return options.at(terminal);
+        case Opcode::Not:
+            return "( NOT " + children[0]->prettyPrint(options) + " )";
+        case Opcode::And:
+            return "( " + children[0]->prettyPrint(options) + " AND "
+                   + children[1]->prettyPrint(options) + " )";
+        case Opcode::Or:
+            return "( " + children[0]->prettyPrint(options) + " OR "
+                   + children[1]->prettyPrint(options) + " )";
+        case Opcode::If:
+            return "( IF " + children[0]->prettyPrint(options) + " THEN "
+                   + children[1]->prettyPrint(options) + " ELSE "
+                   + children[2]->prettyPrint(options) + " )";
+    }
+    throw std::runtime_error{"Invalid opcode"};
+}
+
+void SharedNode::appendGenes(std::vector<Gene>& genes) const {
+    genes.push_back(Gene{op, terminal});
+    for (int i = 0; i < arity(op); i++) {
+        children[i]->appendGenes(genes);
+    }
+}
+
+NodeRef randomSharedTree(std::size_t optionsCount, int depth) {
+    if (depth == 0) {
+        int terminal = uniformIntegerInclusiveBounds(0, static_cast<int>(optionsCount) - 1);
+        return internNode(Opcode::Terminal, static_cast<std::uint16_t>(terminal));
+    }
+    constexpr Opcode operators[]{Opcode::Not, Opcode::And, Opcode::Or, Opcode::If};
+    Opcode op = operators[uniformIntegerInclusiveBounds(0, 3)];
+    NodeRef children[3]{};
+    for (int i = 0; i < arity(op); i++) {
+        children[i] = randomSharedTree(optionsCount, depth - 1);
+    }
+    return internNode(op, 0, std::move(children[0]), std::move(children[1]),
+                      std::move(children[2]));
+}
+
+/*
+ * The path from the root to a chosen child: every step is a node and the index of the child
+ * which the path continues through. The final step is the parent of the chosen child.
+ */
+using Path = std::vector<std::tuple<const SharedNode*, int>>;
+
+/*
+ * Picks an internal node uniformly at random in a single descent guided by the logic sizes, in
+ * the same way as the node trees, then picks one of its children.
+ */
+Path randomChildPath(const NodeRef& head) {
+    assert(head->opcode() != Opcode::Terminal);
+    int index = uniformIntegerInclusiveBounds(0, head->computeLogicSize() - 1);
+    Path path{};
+    const SharedNode* node = head.get();
+    while (index > 0) {
+        index--;
+        for (int i = 0;; i++) {
+            const SharedNode* next = node->child(i).get();
+            if (index < next->computeLogicSize()) {
+                path.emplace_back(node, i);
+                node = next;
+                break;
+            }
+            index -= next->computeLogicSize();
+        }
+    }
+    path.emplace_back(node, uniformIntegerInclusiveBounds(0, arity(node->opcode()) - 1));
+    return path;
+}
+
+/* Rebuilds the nodes along the path with the chosen child replaced, sharing everything else. */
+NodeRef replaceAlongPath(const Path& path, NodeRef replacement) {
+    for (auto step = path.rbegin(); step != path.rend(); ++step) {
+        auto[node, choice] = *step;
+        NodeRef children[3]{};
+        for (int i = 0; i < arity(node->opcode()); i++) {
+            children[i] = i == choice ? std::move(replacement) : node->child(i);
+        }
+        replacement = internNode(node->opcode(), 0, std::move(children[0]),
+                                 std::move(children[1]), std::move(children[2]));
+    }
+    return replacement;
+}
+
+const NodeRef& chosenChild(const Path& path) {
+    auto[node, choice] = path.back();
+    return node->child(choice);
+}
+
+std::tuple<NodeRef, NodeRef> performRecombination(const NodeRef& first, const NodeRef& second) {
+    Path firstPath = randomChildPath(first);
+    Path secondPath = randomChildPath(second);
+    NodeRef firstChild = replaceAlongPath(firstPath, chosenChild(secondPath));
+    NodeRef secondChild = replaceAlongPath(secondPath, chosenChild(firstPath));
+    return std::make_tuple(std::move(firstChild), std::move(secondChild));
+}
+
+NodeRef performMutation(const NodeRef& head, std::size_t optionsCount) {
+    Path path = randomChildPath(head);
+    return replaceAlongPath(path, randomSharedTree(optionsCount, randomMutationDepth()));
+}
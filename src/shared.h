@@ -0,0 +1,96 @@
+#ifndef GENETIC_MULTIPLEXER_SHARED_H
+#define GENETIC_MULTIPLEXER_SHARED_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "bitslice.h"
+#include "genome.h"
+
+class SharedNode;
+
+/* An owning, reference counted handle to an immutable node. */
+class NodeRef
+{
+private:
+    SharedNode* node{nullptr};
+public:
+    NodeRef() = default;
+    /* Adopts a reference which the caller already holds. */
+    explicit NodeRef(SharedNode* node);
+    NodeRef(const NodeRef& other);
+    NodeRef(NodeRef&& other) noexcept;
+    NodeRef& operator=(NodeRef other) noexcept;
+    ~NodeRef();
+    [[nodiscard]] const SharedNode* get() const;
+    [[nodiscard]] const SharedNode* operator->() const;
+    [[nodiscard]] const SharedNode& operator*() const;
+    explicit operator bool() const;
+};
+
+/*
+ * An immutable node which is hash-consed, meaning that there is never more than one live node
+ * with the same operator and children. Structurally identical subtrees are therefore the same
+ * nodes, shared by every tree which contains them. The depth, logic size, and structural hash
+ * are computed once when the node is created.
+ */
+class SharedNode
+{
+private:
+    Opcode op;
+    std::uint16_t terminal;
+    int depth;
+    int logicSize;
+    std::uint64_t hash;
+    NodeRef children[3];
+    std::atomic<int> references{1};
+    /* Takes a reference to the node unless its count already dropped to zero. */
+    [[nodiscard]] bool tryReference();
+    friend class NodeRef;
+    friend NodeRef internNode(Opcode op, std::uint16_t terminal, NodeRef first, NodeRef second,
+                              NodeRef third);
+    friend void unreference(SharedNode* node);
+    SharedNode(Opcode op, std::uint16_t terminal, std::uint64_t hash, NodeRef first,
+               NodeRef second, NodeRef third);
+public:
+    [[nodiscard]] Opcode opcode() const;
+    /* Only meaningful for terminal nodes. */
+    [[nodiscard]] std::uint16_t terminalIndex() const;
+    [[nodiscard]] const NodeRef& child(int index) const;
+    [[nodiscard]] int computeDepth() const;
+    [[nodiscard]] int computeLogicSize() const;
+    [[nodiscard]] std::uint64_t computeHash() const;
+    [[nodiscard]] bool evaluate(const std::vector<char>& truthTable) const;
+    /* Same scratch requirements as Expr::evaluate. */
+    void evaluate(const RowBlock& block, std::uint64_t* out, std::uint64_t* scratch) const;
+    [[nodiscard]] std::string prettyPrint(const std::vector<std::string>& options) const;
+    /* Appends the genes of this subtree in prefix order, repeating shared subtrees. */
+    void appendGenes(std::vector<Gene>& genes) const;
+};
+
+/* Returns the unique node with the operator and children, creating it if it does not exist. */
+NodeRef internNode(Opcode op, std::uint16_t terminal, NodeRef first = {}, NodeRef second = {},
+                   NodeRef third = {});
+
+/* Returns the shared tree with the genes in prefix order. */
+NodeRef internGenes(const std::vector<Gene>& genes);
+
+/* The number of live nodes across all shared trees. */
+std::size_t sharedNodeCount();
+
+/* Generates a random shared tree with the same distribution as randomNode. */
+NodeRef randomSharedTree(std::size_t optionsCount, int depth);
+
+/*
+ * Swaps a random child subtree between both trees. Only the nodes on the path from each root
+ * to the swapped child are rebuilt; everything else is shared with the parents.
+ */
+std::tuple<NodeRef, NodeRef> performRecombination(const NodeRef& first, const NodeRef& second);
+
+/* Replaces a random child subtree by a random subtree, rebuilding only the path to it. */
+NodeRef performMutation(const NodeRef& head, std::size_t optionsCount);
+
+#endif
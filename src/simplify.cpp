@@ -0,0 +1,174 @@
+#include <cassert>
+#include <utility>
+#include "genome.h"
+#include "simplify.h"
+
+thread_local std::uint64_t simplifiedSize{0};
+
+/* What a subtree is known to output on every row. */
+enum class Value
+{
+    varying,
+    alwaysFalse,
+    alwaysTrue,
+};
+
+Value negate(Value value) {
+    switch (value) {
+        case Value::alwaysFalse:
+            return Value::alwaysTrue;
+        case Value::alwaysTrue:
+            return Value::alwaysFalse;
+        default:
+            return Value::varying;
+    }
+}
+
+/* A rewritten subtree along with what it is known to output. */
+struct Rewrite
+{
+    std::unique_ptr<Expr> node;
+    Value value;
+};
+
+bool sameTree(const Expr& first, const Expr& second) {
+    Gene firstGene = first.gene();
+    Gene secondGene = second.gene();
+    if (firstGene.op != secondGene.op || firstGene.terminal != secondGene.terminal
+        || first.computeLogicSize() != second.computeLogicSize()
+        || first.computeDepth() != second.computeDepth()) {
+        return false;
+    }
+    for (int i = 0; i < first.childCount(); i++) {
+        if (!sameTree(*first.child(i), *second.child(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Whether either tree is the negation of the other. */
+bool complementary(const Expr& first, const Expr& second) {
+    if (first.gene().op == Opcode::Not && sameTree(*first.child(0), second)) {
+        return true;
+    }
+    return second.gene().op == Opcode::Not && sameTree(*second.child(0), first);
+}
+
+std::unique_ptr<Expr> takeChild(Expr& node, int index) {
+    return node.replaceChild(index, nullptr);
+}
+
+/*
+ * Applies the rewrites at the node, whose children are already simplified and known to output
+ * the values. A rewrite which would leave the root as a terminal is skipped.
+ */
+Rewrite rewrite(std::unique_ptr<Expr> node, const Value* values, bool isRoot) {
+    auto allowed = [isRoot](const Expr& result) {
+        return !isRoot || result.childCount() > 0;
+    };
+    Opcode op = node->gene().op;
+    if (op == Opcode::Not) {
+        Expr* inner = node->child(0);
+        if (inner->gene().op == Opcode::Not && allowed(*inner->child(0))) {
+            return Rewrite{takeChild(*inner, 0), negate(values[0])};
+        }
+        return Rewrite{std::move(node), negate(values[0])};
+    }
+    if (op == Opcode::And || op == Opcode::Or) {
+        Value identity = op == Opcode::And ? Value::alwaysTrue : Value::alwaysFalse;
+        Value absorbing = negate(identity);
+        const Expr& first = *node->child(0);
+        const Expr& second = *node->child(1);
+        if (sameTree(first, second) && allowed(first)) {
+            return Rewrite{takeChild(*node, 0), values[0]};
+        }
+        for (int i = 0; i < 2; i++) {
+            if (values[i] == absorbing && allowed(*node->child(i))) {
+                return Rewrite{takeChild(*node, i), absorbing};
+            }
+            if (values[i] == identity && allowed(*node->child(1 - i))) {
+                return Rewrite{takeChild(*node, 1 - i), values[1 - i]};
+            }
+        }
+        Value value = Value::varying;
+        if (complementary(first, second) || values[0] == absorbing || values[1] == absorbing) {
+            value = absorbing;
+        } else if (values[0] == identity && values[1] == identity) {
+            value = identity;
+        }
+        return Rewrite{std::move(node), value};
+    }
+    if (op == Opcode::If) {
+        const Expr& condition = *node->child(0);
+        const Expr& trueCase = *node->child(1);
+        const Expr& falseCase = *node->child(2);
+        if (values[0] == Value::alwaysTrue && allowed(trueCase)) {
+            return Rewrite{takeChild(*node, 1), values[1]};
+        }
+        if (values[0] == Value::alwaysFalse && allowed(falseCase)) {
+            return Rewrite{takeChild(*node, 2), values[2]};
+        }
+        if (sameTree(trueCase, falseCase) && allowed(trueCase)) {
+            return Rewrite{takeChild(*node, 1), values[1]};
+        }
+        if (sameTree(condition, trueCase)) {
+            auto either = std::make_unique<Or>(takeChild(*node, 0), takeChild(*node, 2));
+            Value eitherValues[]{values[0], values[2]};
+            return rewrite(std::move(either), eitherValues, isRoot);
+        }
+        if (sameTree(condition, falseCase)) {
+            auto both = std::make_unique<And>(takeChild(*node, 0), takeChild(*node, 1));
+            Value bothValues[]{values[0], values[1]};
+            return rewrite(std::move(both), bothValues, isRoot);
+        }
+        if (condition.gene().op == Opcode::Not) {
+            std::unique_ptr<Expr> negated = takeChild(*node, 0);
+            auto swapped = std::make_unique<If>(takeChild(*negated, 0), takeChild(*node, 2),
+                                                takeChild(*node, 1));
+            Value swappedValues[]{negate(values[0]), values[2], values[1]};
+            return rewrite(std::move(swapped), swappedValues, isRoot);
+        }
+        Value value = values[1] == values[2] ? values[1] : Value::varying;
+        if (values[0] == Value::alwaysTrue) {
+            value = values[1];
+        } else if (values[0] == Value::alwaysFalse) {
+            value = values[2];
+        }
+        return Rewrite{std::move(node), value};
+    }
+    return Rewrite{std::move(node), Value::varying};
+}
+
+Rewrite simplifyNode(std::unique_ptr<Expr> node, bool isRoot) {
+    int children = node->childCount();
+    if (children == 0) {
+        return Rewrite{std::move(node), Value::varying};
+    }
+    Value values[3]{};
+    for (int i = 0; i < children; i++) {
+        Rewrite child = simplifyNode(takeChild(*node, i), false);
+        values[i] = child.value;
+        static_cast<void>(node->replaceChild(i, std::move(child.node)));
+    }
+    node->refreshMetadata();
+    return rewrite(std::move(node), values, isRoot);
+}
+
+std::unique_ptr<Expr> simplify(std::unique_ptr<Expr> head) {
+    assert(head != nullptr);
+    return simplifyNode(std::move(head), true).node;
+}
+
+std::unique_ptr<Expr> simplifyOffspring(std::unique_ptr<Expr> head) {
+    int size = head->computeLogicSize();
+    std::unique_ptr<Expr> simplified = simplify(std::move(head));
+    simplifiedSize += size - simplified->computeLogicSize();
+    return simplified;
+}
+
+std::uint64_t takeSimplifiedSize() {
+    std::uint64_t size = simplifiedSize;
+    simplifiedSize = 0;
+    return size;
+}
@@ -0,0 +1,24 @@
+#ifndef GENETIC_MULTIPLEXER_SIMPLIFY_H
+#define GENETIC_MULTIPLEXER_SIMPLIFY_H
+
+#include <cstdint>
+#include <memory>
+#include "expressions.h"
+
+/*
+ * Rewrites the tree bottom-up into an equivalent one which is never larger or deeper, removing
+ * double negations, a conjunction or disjunction of a subtree with itself, a branch whose cases
+ * are the same, a condition repeated as one of its cases, and a negated condition. Subtrees which
+ * are a subtree combined with its own negation are known to be constant, so they decide the
+ * branches, conjunctions, and disjunctions which they are part of. The root is never rewritten
+ * into a terminal, since variation needs a tree with an internal node.
+ */
+std::unique_ptr<Expr> simplify(std::unique_ptr<Expr> head);
+
+/* Simplifies the offspring, adding the logic size it lost to the count of the calling thread. */
+std::unique_ptr<Expr> simplifyOffspring(std::unique_ptr<Expr> head);
+
+/* Returns the logic size removed from the offspring of the calling thread since the last call. */
+std::uint64_t takeSimplifiedSize();
+
+#endif
@@ -0,0 +1,140 @@
+#include <cstdio>
+#include <stdexcept>
+#include "constants.h"
+#include "telemetry.h"
+
+void GenerationCounters::addTime(Phase phase, std::uint64_t nanoseconds) {
+    switch (phase) {
+        case Phase::selection:
+            selectionNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+            return;
+        case Phase::evaluation:
+            evaluationNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+            return;
+        case Phase::variation:
+            variationNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+            return;
+    }
+}
+
+void GenerationCounters::addExactEvaluations(std::uint64_t count) {
+    exactEvaluations.fetch_add(count, std::memory_order_relaxed);
+}
+
+void GenerationCounters::addSampledRows(std::uint64_t rows) {
+    sampledRows.fetch_add(rows, std::memory_order_relaxed);
+}
+
+void GenerationCounters::addNodeCounts(const NodeCounts& counts) {
+    nodeAllocations.fetch_add(counts.allocations, std::memory_order_relaxed);
+    nodeReleases.fetch_add(counts.releases, std::memory_order_relaxed);
+}
+
+void GenerationCounters::addSimplifiedSize(std::uint64_t size) {
+    simplifiedLogicSize.fetch_add(size, std::memory_order_relaxed);
+}
+
+double GenerationCounters::seconds(Phase phase) const {
+    std::uint64_t evaluation = evaluationNanoseconds.load(std::memory_order_relaxed);
+    std::uint64_t nanoseconds = evaluation;
+    if (phase == Phase::selection) {
+        std::uint64_t selection = selectionNanoseconds.load(std::memory_order_relaxed);
+        nanoseconds = selection > evaluation ? selection - evaluation : 0;
+    } else if (phase == Phase::variation) {
+        nanoseconds = variationNanoseconds.load(std::memory_order_relaxed);
+    }
+    return static_cast<double>(nanoseconds) / 1e9;
+}
+
+std::uint64_t GenerationCounters::exactEvaluationCount() const {
+    return exactEvaluations.load(std::memory_order_relaxed);
+}
+
+std::uint64_t GenerationCounters::sampledRowCount() const {
+    return sampledRows.load(std::memory_order_relaxed);
+}
+
+NodeCounts GenerationCounters::nodeCounts() const {
+    return NodeCounts{nodeAllocations.load(std::memory_order_relaxed),
+                      nodeReleases.load(std::memory_order_relaxed)};
+}
+
+std::uint64_t GenerationCounters::simplifiedSize() const {
+    return simplifiedLogicSize.load(std::memory_order_relaxed);
+}
+
+void GenerationCounters::reset() {
+    selectionNanoseconds.store(0, std::memory_order_relaxed);
+    evaluationNanoseconds.store(0, std::memory_order_relaxed);
+    variationNanoseconds.store(0, std::memory_order_relaxed);
+    exactEvaluations.store(0, std::memory_order_relaxed);
+    sampledRows.store(0, std::memory_order_relaxed);
+    nodeAllocations.store(0, std::memory_order_relaxed);
+    nodeReleases.store(0, std::memory_order_relaxed);
+    simplifiedLogicSize.store(0, std::memory_order_relaxed);
+}
+
+PhaseTimer::PhaseTimer(GenerationCounters* counters, Phase phase)
+        : counters{counters}, phase{phase} {
+    if (counters != nullptr) {
+        start = std::chrono::steady_clock::now();
+    }
+}
+
+PhaseTimer::~PhaseTimer() {
+    if (counters == nullptr) {
+        return;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    counters->addTime(phase, static_cast<std::uint64_t>(nanoseconds));
+}
+
+TelemetryStream::TelemetryStream(const std::string& path) {
+    file.open(path, std::ios::out | std::ios::trunc);
+    if (file.fail()) {
+        throw std::runtime_error{"Could not open file: " + path};
+    }
+    buffer.reserve(telemetryBufferBytes);
+}
+
+TelemetryStream::~TelemetryStream() {
+    writeBuffer();
+}
+
+void TelemetryStream::writeBuffer() {
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    buffer.clear();
+}
+
+void TelemetryStream::name(const std::string& field) {
+    buffer += recordStarted ? ", \"" : "{\"";
+    buffer += field;
+    buffer += "\": ";
+    recordStarted = true;
+}
+
+void TelemetryStream::field(const std::string& field, int value) {
+    name(field);
+    buffer += std::to_string(value);
+}
+
+void TelemetryStream::field(const std::string& field, std::uint64_t value) {
+    name(field);
+    buffer += std::to_string(value);
+}
+
+void TelemetryStream::field(const std::string& field, double value) {
+    name(field);
+    char digits[32];
+    std::snprintf(digits, sizeof(digits), "%.9g", value);
+    buffer += digits;
+}
+
+void TelemetryStream::endRecord() {
+    buffer += recordStarted ? "}\n" : "{}\n";
+    recordStarted = false;
+    if (buffer.size() >= telemetryBufferBytes) {
+        writeBuffer();
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef GENETIC_MULTIPLEXER_TELEMETRY_H
+#define GENETIC_MULTIPLEXER_TELEMETRY_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include "arena.h"
+
+/*
+ * Selection covers everything from scoring the samples of a tournament to picking its parents,
+ * so it includes the evaluation done along the way. Variation covers breeding the offspring.
+ */
+enum class Phase
+{
+    selection,
+    evaluation,
+    variation,
+};
+
+/*
+ * The time and work of one generation. Tournaments running on any thread add to the same
+ * counters, so the time of a phase is summed over every thread which took part in it.
+ */
+class GenerationCounters
+{
+private:
+    std::atomic<std::uint64_t> selectionNanoseconds{0};
+    std::atomic<std::uint64_t> evaluationNanoseconds{0};
+    std::atomic<std::uint64_t> variationNanoseconds{0};
+    std::atomic<std::uint64_t> exactEvaluations{0};
+    std::atomic<std::uint64_t> sampledRows{0};
+    std::atomic<std::uint64_t> nodeAllocations{0};
+    std::atomic<std::uint64_t> nodeReleases{0};
+    std::atomic<std::uint64_t> simplifiedLogicSize{0};
+public:
+    void addTime(Phase phase, std::uint64_t nanoseconds);
+    /* Every exact evaluation scores the whole truth table, minus any rows skipped by a bound. */
+    void addExactEvaluations(std::uint64_t count);
+    void addSampledRows(std::uint64_t rows);
+    void addNodeCounts(const NodeCounts& counts);
+    void addSimplifiedSize(std::uint64_t size);
+    /* Excludes the evaluation from the selection, even though one includes the other. */
+    [[nodiscard]] double seconds(Phase phase) const;
+    [[nodiscard]] std::uint64_t exactEvaluationCount() const;
+    [[nodiscard]] std::uint64_t sampledRowCount() const;
+    [[nodiscard]] NodeCounts nodeCounts() const;
+    /* The logic size which simplification removed from the offspring. */
+    [[nodiscard]] std::uint64_t simplifiedSize() const;
+    void reset();
+};
+
+/* Adds the time from its construction to its destruction to the phase, unless counters are off. */
+class PhaseTimer
+{
+private:
+    GenerationCounters* counters;
+    Phase phase;
+    std::chrono::steady_clock::time_point start{};
+public:
+    PhaseTimer(GenerationCounters* counters, Phase phase);
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+    ~PhaseTimer();
+};
+
+/*
+ * Writes one JSON object per line to a file. Records are collected in memory and only written
+ * out once enough of them add up, so a record does not cost a system call; whatever is left is
+ * written out when the stream is destroyed.
+ */
+class TelemetryStream
+{
+private:
+    std::ofstream file{};
+    std::string buffer{};
+    bool recordStarted{false};
+    void name(const std::string& field);
+    void writeBuffer();
+public:
+    explicit TelemetryStream(const std::string& path);
+    TelemetryStream(const TelemetryStream&) = delete;
+    TelemetryStream& operator=(const TelemetryStream&) = delete;
+    ~TelemetryStream();
+    void field(const std::string& field, int value);
+    void field(const std::string& field, std::uint64_t value);
+    void field(const std::string& field, double value);
+    void endRecord();
+};
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef GENETIC_MULTIPLEXER_TOURNAMENT_H
+#define GENETIC_MULTIPLEXER_TOURNAMENT_H
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "constants.h"
+#include "evolution.h"
+
+/* A tree along with its structural hash and fitness, which are only known once it is scored. */
+template<typename Tree>
+struct Individual
+{
+    Tree tree{};
+    std::uint64_t hash{0};
+    double fitness{-1};
+};
+
+/*
+ * Returns the fitness of the individual, evaluating the tree only if the individual was not
+ * already scored and its structure is not in the cache. When sampling, only a tree which is
+ * correct on every sampled row goes on to the exact evaluation. When bounded, the evaluation
+ * stops once the tree cannot beat the bound; the individual then stays unscored and this returns
+ * zero, which never beats a bound.
+ */
+template<typename Layout, typename Tree = typename Layout::Tree>
+double score(Individual<Tree>& individual, const Scoring& scoring, double bound) {
+    if (individual.fitness >= 0) {
+        return individual.fitness;
+    }
+    PhaseTimer timer{scoring.counters, Phase::evaluation};
+    if (scoring.sample != nullptr) {
+        individual.fitness = Layout::sampledFitness(individual.tree, *scoring.sample);
+        if (scoring.counters != nullptr) {
+            scoring.counters->addSampledRows(scoring.sample->rowCount());
+        }
+        if (individual.fitness < 1) {
+            return individual.fitness;
+        }
+    }
+    if (scoring.cache != nullptr) {
+        individual.hash = Layout::hash(individual.tree);
+        if (scoring.cache->lookup(individual.hash, individual.fitness)) {
+            return individual.fitness;
+        }
+    }
+    double fitness = Layout::fitness(individual.tree, scoring, scoring.bounded ? bound : -1);
+    if (scoring.counters != nullptr) {
+        scoring.counters->addExactEvaluations(1);
+    }
+    if (fitness < 0) {
+        individual.fitness = -1;
+        return 0;
+    }
+    individual.fitness = fitness;
+    if (scoring.cache != nullptr) {
+        scoring.cache->insert(individual.hash, individual.fitness);
+    }
+    return individual.fitness;
+}
+
+/*
+ * Picks the two fittest of the samples, moving them out of the samples. A sample only matters if
+ * it beats the second fittest so far, so that is the bound it is scored against.
+ */
+template<typename Layout, typename Tree = typename Layout::Tree>
+std::tuple<Individual<Tree>, Individual<Tree>, double>
+selectParents(const Scoring& scoring, Individual<Tree>* samples, int count) {
+    PhaseTimer timer{scoring.counters, Phase::selection};
+    Individual<Tree> firstHead{};
+    Individual<Tree> secondHead{};
+    double firstFitness = 0;
+    double secondFitness = 0;
+    for (int i = 0; i < count; i++) {
+        Individual<Tree>& head = samples[i];
+        double fitness = score<Layout>(head, scoring, secondFitness);
+        if (fitness > firstFitness) {
+            firstHead = std::move(head);
+            firstFitness = fitness;
+        } else if (fitness > secondFitness) {
+            secondHead = std::move(head);
+            secondFitness = fitness;
+        }
+    }
+    if (secondFitness > firstFitness) {
+        std::swap(firstFitness, secondFitness);
+        std::swap(firstHead, secondHead);
+    }
+    assert(firstFitness >= secondFitness);
+    return std::make_tuple(std::move(firstHead), std::move(secondHead), firstFitness);
+}
+
+/*
+ * Samples a tournament without replacement from the first remaining individuals, using one step
+ * of a Fisher-Yates shuffle per sample: each drawn individual is swapped to the end of the
+ * remaining range, which then shrinks past it. The losers stay where they were drawn to, so
+ * they are released together with the rest of the population at the end of the generation.
+ */
+template<typename Layout, typename Tree = typename Layout::Tree>
+std::tuple<Individual<Tree>, Individual<Tree>, double>
+tournamentSelection(const Scoring& scoring, std::vector<Individual<Tree>>& samples,
+                    int& remaining) {
+    assert(remaining >= selectionPerTournament);
+    for (int i = 0; i < selectionPerTournament; i++) {
+        int index = uniformIntegerInclusiveBounds(0, remaining - 1);
+        std::swap(samples[index], samples[remaining - 1]);
+        remaining--;
+    }
+    return selectParents<Layout>(scoring, samples.data() + remaining, selectionPerTournament);
+}
+
+/*
+ * Writes the offspring of a tournament, as many as there were samples in it. Copies of a parent
+ * keep its hash and fitness, so they are never evaluated again.
+ */
+template<typename Layout, typename Tree = typename Layout::Tree>
+void breed(const Individual<Tree>& parentOne, const Individual<Tree>& parentTwo,
+           const std::vector<std::string>& options, Individual<Tree>* children) {
+    for (int k = 0; k < selectionPerTournament; k += 2) {
+        if (uniformReal() < crossoverProbability) {
+            auto[childOne, childTwo] = Layout::recombine(parentOne.tree, parentTwo.tree);
+            children[k] = Individual<Tree>{std::move(childOne)};
+            children[k + 1] = Individual<Tree>{std::move(childTwo)};
+        } else if (uniformReal() < mutationProbability / (1 - crossoverProbability)) {
+            children[k] = Individual<Tree>{Layout::mutate(parentOne.tree, options)};
+            children[k + 1] = Individual<Tree>{Layout::mutate(parentTwo.tree, options)};
+        } else {
+            Tree copyOne = Layout::copy(parentOne.tree);
+            Tree copyTwo = Layout::copy(parentTwo.tree);
+            children[k] = Individual<Tree>{std::move(copyOne), parentOne.hash, parentOne.fitness};
+            children[k + 1] = Individual<Tree>{std::move(copyTwo), parentTwo.hash,
+                                               parentTwo.fitness};
+        }
+    }
+}
+
+/*
+ * Runs the tournaments of one generation one after another, drawing each from what remains of
+ * the population, and writes the offspring to the next population. Returns the best fitness of
+ * the generation, and the pretty printed tree of its best individual.
+ */
+template<typename Layout, typename Tree = typename Layout::Tree>
+std::tuple<double, std::string>
+sequentialGeneration(const Scoring& scoring, const std::vector<std::string>& options,
+                     std::vector<Individual<Tree>>& population,
+                     std::vector<Individual<Tree>>& updatedPopulation) {
+    double bestFitnessIteration = 0;
+    std::string prettyTree{};
+    int tournaments = populationSize / selectionPerTournament;
+    int remaining = populationSize;
+    for (int j = 0; j < tournaments; j++) {
+        auto tuple = tournamentSelection<Layout>(scoring, population, remaining);
+        auto[parentOne, parentTwo, bestParentFitness] = std::move(tuple);
+        if (bestParentFitness > bestFitnessIteration) {
+            bestFitnessIteration = bestParentFitness;
+            prettyTree = Layout::prettyPrint(parentOne.tree, options);
+        }
+        PhaseTimer timer{scoring.counters, Phase::variation};
+        auto* children = updatedPopulation.data() + j * selectionPerTournament;
+        breed<Layout>(parentOne, parentTwo, options, children);
+    }
+    population.clear();
+    return std::make_tuple(bestFitnessIteration, std::move(prettyTree));
+}
+
+#endif
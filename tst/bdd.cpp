@@ -0,0 +1,60 @@
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "../src/bdd.h"
+#include "../src/genome.h"
+
+/* Six address pins have seventy options, more than a double can count the rows of exactly. */
+constexpr std::size_t addressPins{6};
+constexpr std::size_t optionsCount{addressPins + (std::size_t{1} << addressPins)};
+
+/* Appends the multiplexer in prefix order, with address pin zero as the most significant bit. */
+void appendMultiplexer(std::vector<Gene>& genes, std::size_t pin, std::size_t address) {
+    if (pin == addressPins) {
+        genes.push_back(Gene{Opcode::Terminal, static_cast<std::uint16_t>(addressPins + address)});
+        return;
+    }
+    genes.push_back(Gene{Opcode::If, 0});
+    genes.push_back(Gene{Opcode::Terminal, static_cast<std::uint16_t>(pin)});
+    appendMultiplexer(genes, pin + 1, 2 * address + 1);
+    appendMultiplexer(genes, pin + 1, 2 * address);
+}
+
+/* The multiplexer, except on the single row where every pin is true, where it is negated. */
+std::vector<Gene> oneRowWrong() {
+    std::vector<Gene> genes{Gene{Opcode::If, 0}};
+    for (std::size_t pin = 0; pin + 1 < optionsCount; pin++) {
+        genes.push_back(Gene{Opcode::And, 0});
+        genes.push_back(Gene{Opcode::Terminal, static_cast<std::uint16_t>(pin)});
+    }
+    genes.push_back(Gene{Opcode::Terminal, static_cast<std::uint16_t>(optionsCount - 1)});
+    genes.push_back(Gene{Opcode::Not, 0});
+    appendMultiplexer(genes, 0, 0);
+    appendMultiplexer(genes, 0, 0);
+    return genes;
+}
+
+/*
+ * Checks that the decision diagram counts the rows of a six address pin tree exactly, so that a
+ * tree which is wrong on a single row is not scored as the multiplexer.
+ */
+int main() {
+    BddManager::Count rows = BddManager::Count{1} << optionsCount;
+    std::vector<Gene> perfect{};
+    appendMultiplexer(perfect, 0, 0);
+    std::vector<Gene> imperfect = oneRowWrong();
+    BddManager manager{addressPins, optionsCount};
+    if (manager.agreeingRows(manager.compile(perfect)) != rows
+        || bddAgreement(perfect, addressPins, optionsCount) != 1) {
+        std::cerr << "Error: the multiplexer does not agree on every row" << std::endl;
+        return -1;
+    }
+    if (manager.agreeingRows(manager.compile(imperfect)) != rows - 1
+        || !(bddAgreement(imperfect, addressPins, optionsCount) < 1)) {
+        std::cerr << "Error: a tree wrong on one row is not counted exactly" << std::endl;
+        return -1;
+    }
+    std::cout << "Success: the decision diagram counts rows exactly" << std::endl;
+    return 0;
+}
@@ -1,142 +1,372 @@
-#include <cassert>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <sstream>
-#include <stack>
+#include <stdexcept>
 #include <string>
-#include <tuple>
-#include <unordered_set>
+#include <thread>
+#include <utility>
 #include <vector>
 
-void evaluateExpression(std::vector<std::string>& tree, int start, int end) {
-    assert(start < end);
-    assert(tree[start] == "(");
-    assert(tree[end] == ")");
-    if (tree[start + 1] == "NOT") {
-        assert(start + 3 == end);
-        int notExpr = tree[start + 2][0] - '0';
-        int evaluation = !notExpr;
-        tree.erase(tree.begin() + start + 1, tree.begin() + end + 1);
-        tree[start] = evaluation + '0';
-        return;
+/* The number of 64-row words evaluated by a single pass over the program. */
+constexpr int blockShift{6};
+constexpr std::size_t blockWords{1U << blockShift};
+
+enum class Instruction
+{
+    Pin,
+    Not,
+    And,
+    Or,
+    If,
+};
+
+/* The pin is only meaningful for Pin, and indexes address pins first, then data pins. */
+struct Operation
+{
+    Instruction instruction;
+    int pin;
+};
+
+/* A tree compiled into postfix order, where And, Or, and If pop their operands in reverse. */
+struct Program
+{
+    std::vector<Operation> operations{};
+    int addressPins{0};
+    int dataPins{0};
+    int maximumStack{0};
+};
+
+std::vector<std::string> splitTree(const std::string& tree) {
+    std::vector<std::string> splitTree{};
+    std::istringstream stream{tree};
+    std::string cur{};
+    while (stream >> cur) {
+        splitTree.push_back(cur);
     }
-    if (tree[start + 1] == "IF") {
-        assert(start + 7 == end);
-        int ifExpr = tree[start + 2][0] - '0';
-        int trueExpr = tree[start + 4][0] - '0';
-        int falseExpr = tree[start + 6][0] - '0';
-        int evaluation = ifExpr ? trueExpr : falseExpr;
-        tree.erase(tree.begin() + start + 1, tree.begin() + end + 1);
-        tree[start] = evaluation + '0';
-        return;
+    return splitTree;
+}
+
+/* Parses pin names of any length, such as a0 or d12. */
+int pinIndex(const std::string& token) {
+    if (token.size() < 2 || (token[0] != 'a' && token[0] != 'd')
+        || token.find_first_not_of("0123456789", 1) != std::string::npos) {
+        throw std::runtime_error{"unexpected token (" + token + ")"};
     }
-    if (tree[start + 2] == "AND") {
-        assert(start + 4 == end);
-        int firstExpr = tree[start + 1][0] - '0';
-        int secondExpr = tree[start + 3][0] - '0';
-        int evaluation = firstExpr & secondExpr;
-        tree.erase(tree.begin() + start + 1, tree.begin() + end + 1);
-        tree[start] = evaluation + '0';
-        return;
+    return std::stoi(token.substr(1));
+}
+
+class Parser
+{
+private:
+    const std::vector<std::string>& tokens;
+    std::size_t index{0};
+    std::vector<Operation> operations{};
+    std::vector<std::size_t> dataOperations{};
+    int addressPins{1};
+    int highestData{0};
+    int stack{0};
+    int maximumStack{0};
+
+    const std::string& next() {
+        if (index == tokens.size()) {
+            throw std::runtime_error{"tree ends early"};
+        }
+        return tokens[index++];
     }
-    if (tree[start + 2] == "OR") {
-        assert(start + 4 == end);
-        int firstExpr = tree[start + 1][0] - '0';
-        int secondExpr = tree[start + 3][0] - '0';
-        int evaluation = firstExpr | secondExpr;
-        tree.erase(tree.begin() + start + 1, tree.begin() + end + 1);
-        tree[start] = evaluation + '0';
-        return;
+
+    const std::string& peek() const {
+        if (index == tokens.size()) {
+            throw std::runtime_error{"tree ends early"};
+        }
+        return tokens[index];
+    }
+
+    void expect(const std::string& token) {
+        const std::string& actual = next();
+        if (actual != token) {
+            throw std::runtime_error{"expected " + token + " but found " + actual};
+        }
     }
-    assert(false);
-}
 
-bool evaluateTree(std::vector<std::string> tree,
-                  const std::vector<int>& address, const std::vector<int>& data) {
-    for (std::size_t i = 0; i < tree.size(); i++) {
-        if (tree[i][0] == 'a') {
-            int number = tree[i][1] - '0';
-            int value = address[number];
-            tree[i] = std::to_string(value);
-        } else if (tree[i][0] == 'd') {
-            int number = tree[i][1] - '0';
-            int value = data[number];
-            tree[i] = std::to_string(value);
-        }
-    }
-    while (true) {
-        std::stack<int> stack{};
-        for (std::size_t i = 0; i < tree.size(); i++) {
-            if (tree[i] == "(") {
-                stack.push(i);
-                continue;
+    void emit(Instruction instruction, int popped) {
+        operations.push_back(Operation{instruction, 0});
+        stack -= popped - 1;
+    }
+
+    void expression() {
+        const std::string& token = next();
+        if (token != "(") {
+            int pin = pinIndex(token);
+            if (token[0] == 'a') {
+                addressPins = std::max(addressPins, pin + 1);
+            } else {
+                highestData = std::max(highestData, pin);
+                dataOperations.push_back(operations.size());
             }
-            if (tree[i] == ")") {
-                int end = i;
-                int start = stack.top();
-                evaluateExpression(tree, start, end);
-                break;
+            operations.push_back(Operation{Instruction::Pin, pin});
+            stack++;
+            maximumStack = std::max(maximumStack, stack);
+            return;
+        }
+        if (peek() == "NOT") {
+            index++;
+            expression();
+            emit(Instruction::Not, 1);
+        } else if (peek() == "IF") {
+            index++;
+            expression();
+            expect("THEN");
+            expression();
+            expect("ELSE");
+            expression();
+            emit(Instruction::If, 3);
+        } else {
+            expression();
+            const std::string& op = next();
+            if (op != "AND" && op != "OR") {
+                throw std::runtime_error{"unexpected token (" + op + ")"};
             }
+            expression();
+            emit(op == "AND" ? Instruction::And : Instruction::Or, 2);
+        }
+        expect(")");
+    }
+
+public:
+    explicit Parser(const std::vector<std::string>& tokens) : tokens{tokens} {}
+
+    /*
+     * The address pin count is the smallest which covers every pin named by the tree. Data pins
+     * are only numbered after the address pins once that count is known.
+     */
+    Program parse() {
+        expression();
+        if (index != tokens.size()) {
+            throw std::runtime_error{"trailing tokens after the tree"};
         }
-        if (stack.empty()) {
-            assert(tree.size() == 1);
-            return tree[0][0] - '0';
+        while (addressPins < 6 && highestData >= (1 << addressPins)) {
+            addressPins++;
         }
+        if (addressPins + (1 << addressPins) >= 64 || highestData >= (1 << addressPins)) {
+            throw std::runtime_error{"too many pins to enumerate every row"};
+        }
+        for (std::size_t i : dataOperations) {
+            operations[i].pin += addressPins;
+        }
+        return Program{operations, addressPins, 1 << addressPins, maximumStack};
+    }
+};
+
+/*
+ * Row r sets data pin j to bit j of r, and address pins to the bits above the data pins, with
+ * a0 as the most significant bit. Pins in the low six bits follow a fixed pattern within a word,
+ * and every other pin is the same for the whole word.
+ */
+int pinBit(const Program& program, int pin) {
+    if (pin < program.addressPins) {
+        return program.dataPins + (program.addressPins - 1 - pin);
     }
+    return pin - program.addressPins;
 }
 
-bool isValid(const std::vector<std::string>& tree, int addressPinsLeft, int dataPinsLeft,
-             std::vector<int> address, std::vector<int> data) {
-    if (addressPinsLeft == 0 && dataPinsLeft == 0) {
-        int offset{0};
-        for (int a : address) {
-            assert(a == 0 || a == 1);
-            offset *= 2;
-            offset += a;
-        }
-        int mappedTruth = data.at(offset);
-        int treeTruth = evaluateTree(tree, address, data);
-        return mappedTruth == treeTruth;
-    }
-    if (addressPinsLeft == 0) {
-        data.emplace_back(0);
-        bool first = isValid(tree, 0, dataPinsLeft - 1, address, data);
-        data.pop_back();
-        data.emplace_back(1);
-        bool second = isValid(tree, 0, dataPinsLeft - 1, address, data);
-        data.pop_back();
-        return first && second;
-    }
-    address.emplace_back(0);
-    bool first = isValid(tree, addressPinsLeft - 1, dataPinsLeft, address, data);
-    address.pop_back();
-    address.emplace_back(1);
-    bool second = isValid(tree, addressPinsLeft - 1, dataPinsLeft, address, data);
-    address.pop_back();
-    return first && second;
+std::uint64_t pinWord(const Program& program, int pin, std::uint64_t word) {
+    static constexpr std::uint64_t patterns[6]{
+            0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+            0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL,
+    };
+    int bit = pinBit(program, pin);
+    if (bit < 6) {
+        return patterns[bit];
+    }
+    return ((word >> (bit - 6)) & 1U) ? ~0ULL : 0;
+}
+
+/*
+ * An entry of the evaluation stack. Blocks start at a multiple of the block words, so every pin
+ * outside the bits which count words within a block holds the same word across the whole block,
+ * and so do many of the subtrees built from them. Such an entry is uniform and holds just that
+ * word; any other entry holds one word per word of the block.
+ */
+struct Entry
+{
+    bool uniform;
+    std::uint64_t word;
+    std::uint64_t* words;
+};
+
+void loadPin(const Program& program, int pin, std::uint64_t firstWord, std::size_t words,
+             Entry& entry) {
+    int bit = pinBit(program, pin);
+    entry.uniform = bit < 6 || bit >= 6 + blockShift;
+    if (entry.uniform) {
+        entry.word = pinWord(program, pin, firstWord);
+        return;
+    }
+    int shift = bit - 6;
+    for (std::size_t w = 0; w < words; w++) {
+        entry.words[w] = 0 - (((firstWord + w) >> shift) & 1U);
+    }
+}
+
+void materialize(Entry& entry, std::size_t words) {
+    if (entry.uniform) {
+        std::fill(entry.words, entry.words + words, entry.word);
+        entry.uniform = false;
+    }
 }
 
-std::tuple<int, int> pinsCount(const std::vector<std::string>& tree) {
-    std::unordered_set<std::string> addressPins{};
-    std::unordered_set<std::string> dataPins{};
-    for (auto str : tree) {
-        if (str.rfind("a", 0) == 0) {
-            addressPins.emplace(str);
-        } else if (str.rfind("d", 0) == 0) {
-            dataPins.emplace(str);
+/* Moves the source into the destination, swapping their storage rather than copying words. */
+void assign(Entry& destination, Entry& source) {
+    destination.uniform = source.uniform;
+    destination.word = source.word;
+    std::swap(destination.words, source.words);
+}
+
+/*
+ * Returns whether the program computes the multiplexer on every row of the words. With at least
+ * six data pins, the address is the same for every row of a word, so the expected word is simply
+ * the addressed data pin.
+ */
+bool checkWords(const Program& program, std::uint64_t firstWord, std::size_t words,
+                std::uint64_t validMask, std::vector<Entry>& stack) {
+    std::size_t depth = 0;
+    for (const Operation& operation : program.operations) {
+        if (operation.instruction == Instruction::Pin) {
+            loadPin(program, operation.pin, firstWord, words, stack[depth++]);
+            continue;
+        }
+        Entry& last = stack[depth - 1];
+        switch (operation.instruction) {
+            case Instruction::Not:
+                if (last.uniform) {
+                    last.word = ~last.word;
+                    break;
+                }
+                for (std::size_t w = 0; w < words; w++) {
+                    last.words[w] = ~last.words[w];
+                }
+                break;
+            case Instruction::And:
+            case Instruction::Or: {
+                bool isAnd = operation.instruction == Instruction::And;
+                Entry& first = stack[depth - 2];
+                depth--;
+                if (first.uniform && last.uniform) {
+                    first.word = isAnd ? first.word & last.word : first.word | last.word;
+                    break;
+                }
+                if (first.uniform || last.uniform) {
+                    Entry& uniform = first.uniform ? first : last;
+                    std::uint64_t absorbing = isAnd ? 0 : ~0ULL;
+                    if (uniform.word == absorbing) {
+                        first.uniform = true;
+                        first.word = absorbing;
+                        break;
+                    }
+                    if (uniform.word == ~absorbing) {
+                        if (first.uniform) {
+                            assign(first, last);
+                        }
+                        break;
+                    }
+                }
+                materialize(first, words);
+                materialize(last, words);
+                for (std::size_t w = 0; w < words; w++) {
+                    first.words[w] = isAnd ? first.words[w] & last.words[w]
+                                           : first.words[w] | last.words[w];
+                }
+                break;
+            }
+            case Instruction::If: {
+                Entry& condition = stack[depth - 3];
+                Entry& trueCase = stack[depth - 2];
+                depth -= 2;
+                if (condition.uniform && (condition.word == 0 || condition.word == ~0ULL)) {
+                    assign(condition, condition.word != 0 ? trueCase : last);
+                    break;
+                }
+                if (trueCase.uniform && last.uniform && trueCase.word == last.word) {
+                    assign(condition, last);
+                    break;
+                }
+                materialize(condition, words);
+                materialize(trueCase, words);
+                materialize(last, words);
+                for (std::size_t w = 0; w < words; w++) {
+                    std::uint64_t select = condition.words[w];
+                    condition.words[w] = (select & trueCase.words[w]) | (~select & last.words[w]);
+                }
+                break;
+            }
+            case Instruction::Pin:
+                break;
         }
     }
-    return std::make_tuple(addressPins.size(), dataPins.size());
+    const Entry& result = stack[0];
+    for (std::size_t w = 0; w < words; w++) {
+        std::uint64_t word = firstWord + w;
+        std::uint64_t target = 0;
+        if (program.dataPins >= 6) {
+            std::uint64_t address = word >> (program.dataPins - 6);
+            target = pinWord(program, program.addressPins + static_cast<int>(address), word);
+        }
+        for (int address = 0; program.dataPins < 6 && address < program.dataPins; address++) {
+            std::uint64_t match = pinWord(program, program.addressPins + address, word);
+            for (int i = 0; i < program.addressPins; i++) {
+                std::uint64_t pin = pinWord(program, i, word);
+                bool set = (address >> (program.addressPins - 1 - i)) & 1;
+                match &= set ? pin : ~pin;
+            }
+            target |= match;
+        }
+        std::uint64_t computed = result.uniform ? result.word : result.words[w];
+        if (((computed ^ target) & validMask) != 0) {
+            return false;
+        }
+    }
+    return true;
 }
 
-std::vector<std::string> splitTree(std::string tree) {
-    std::vector<std::string> splitTree{};
-    std::istringstream stream{tree};
-    std::string cur{};
-    while (stream >> cur) {
-        splitTree.push_back(cur);
+/* Spreads blocks of words over every hardware thread, stopping them all at the first error. */
+bool isValid(const Program& program) {
+    int rowBits = program.addressPins + program.dataPins;
+    std::uint64_t words = rowBits <= 6 ? 1 : 1ULL << (rowBits - 6);
+    std::uint64_t validMask = rowBits >= 6 ? ~0ULL : (1ULL << (1U << rowBits)) - 1;
+    std::uint64_t blocks = (words + blockWords - 1) / blockWords;
+    std::atomic<std::uint64_t> nextBlock{0};
+    std::atomic<bool> valid{true};
+    auto work = [&]() {
+        std::vector<std::uint64_t> storage((program.maximumStack + 1) * blockWords);
+        std::vector<Entry> stack{};
+        for (int i = 0; i <= program.maximumStack; i++) {
+            stack.push_back(Entry{true, 0, storage.data() + i * blockWords});
+        }
+        while (valid.load(std::memory_order_relaxed)) {
+            std::uint64_t block = nextBlock.fetch_add(1, std::memory_order_relaxed);
+            if (block >= blocks) {
+                return;
+            }
+            std::uint64_t firstWord = block * blockWords;
+            std::size_t count = std::min<std::uint64_t>(blockWords, words - firstWord);
+            if (!checkWords(program, firstWord, count, validMask, stack)) {
+                valid.store(false, std::memory_order_relaxed);
+            }
+        }
+    };
+    unsigned threadCount = std::max(1U, std::thread::hardware_concurrency());
+    std::vector<std::thread> threads{};
+    for (unsigned i = 1; i < threadCount && i < blocks; i++) {
+        threads.emplace_back(work);
     }
-    return splitTree;
+    work();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    return valid.load();
 }
 
 std::string getTree(int argc, char* argv[]) {
@@ -161,12 +391,15 @@ int main(int argc, char* argv[]) {
         std::cerr << "Could not read logic tree" << std::endl;
         return -1;
     }
-    auto split = splitTree(tree);
-    auto[addressPins, dataPins] = pinsCount(split);
-    std::vector<int> address{};
-    std::vector<int> data{};
-    bool isMuxValid = isValid(split, addressPins, dataPins, address, data);
-    if (!isMuxValid) {
+    Program program{};
+    try {
+        std::vector<std::string> tokens = splitTree(tree);
+        program = Parser{tokens}.parse();
+    } catch (const std::exception& e) {
+        std::cerr << "Could not parse logic tree: " << e.what() << std::endl;
+        return -1;
+    }
+    if (!isValid(program)) {
         std::cerr << "Error: the multiplexer is invalid" << std::endl;
         return -1;
     }
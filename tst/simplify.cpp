@@ -0,0 +1,69 @@
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../src/expressions.h"
+#include "../src/random.h"
+#include "../src/simplify.h"
+
+/* The number of random trees drawn for each address pin count and depth. */
+constexpr int treesPerDepth{200};
+constexpr int largestDepth{8};
+constexpr int largestAddressPins{3};
+
+std::vector<std::string> makeOptions(int addressPins) {
+    std::vector<std::string> options{};
+    for (int i = 0; i < addressPins; i++) {
+        options.emplace_back(std::string{"a"} + std::to_string(i));
+    }
+    for (int i = 0; i < (1 << addressPins); i++) {
+        options.emplace_back(std::string{"d"} + std::to_string(i));
+    }
+    return options;
+}
+
+/* Whether both trees agree on every row of the truth table over the options. */
+bool sameOutputs(const Expr& first, const Expr& second, std::size_t optionsCount) {
+    std::vector<char> row(optionsCount, 0);
+    for (std::uint64_t i = 0; i < (std::uint64_t{1} << optionsCount); i++) {
+        for (std::size_t pin = 0; pin < optionsCount; pin++) {
+            row[pin] = static_cast<char>((i >> pin) & 1U);
+        }
+        if (first.evaluate(row) != second.evaluate(row)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Simplifies random trees of every depth and checks that each rewrite computes the same function
+ * and is never larger or deeper than the tree it came from.
+ */
+int main() {
+    seedGenerator(1);
+    for (int addressPins = 1; addressPins <= largestAddressPins; addressPins++) {
+        auto options = makeOptions(addressPins);
+        for (int depth = 1; depth <= largestDepth; depth++) {
+            for (int i = 0; i < treesPerDepth; i++) {
+                auto original = randomNode(options, depth);
+                auto simplified = simplify(original->clone());
+                if (!sameOutputs(*original, *simplified, options.size())) {
+                    std::cerr << "Error: simplification changed the logic of a tree with "
+                              << addressPins << " address pins" << std::endl;
+                    return -1;
+                }
+                if (simplified->computeLogicSize() > original->computeLogicSize()
+                    || simplified->computeDepth() > original->computeDepth()) {
+                    std::cerr << "Error: simplification grew a tree with " << addressPins
+                              << " address pins" << std::endl;
+                    return -1;
+                }
+            }
+        }
+    }
+    std::cout << "Success: simplification preserves the logic" << std::endl;
+    return 0;
+}